@@ -0,0 +1,232 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include "sorting.h"
+
+// Sorts data and collapses equal values as it goes: data is left sorted with every value once and
+// emit(value, count) is called for each of them in order. Ints go through counting or radix passes
+// whose final pass does the collapsing, everything else, and ints that would need all four radix
+// passes, through a merge whose last level does it.
+template <class t, class emit_t>
+void sort_aggregate(std::vector<t> &data, Comparator::Comparator comp, Stats* stats, emit_t emit, std::false_type)
+{
+	size_t size = data.size();
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	auto before = [comp, stats](const t &x, const t &y)
+	{
+		stats->compares++;
+		return compare(comp, x, y, true);
+	};
+
+	// Every level but the last
+	size_t mid = size / 2;
+	Stats* half = hybrid_sort(data.begin(), data.begin() + mid, comp);
+	add_stats(stats, *half);
+	delete half;
+
+	half = hybrid_sort(data.begin() + mid, data.end(), comp);
+	add_stats(stats, *half);
+	delete half;
+
+	// The last merge writes from the front of data, which never overtakes the right run
+	std::vector<t> left(std::make_move_iterator(data.begin()), std::make_move_iterator(data.begin() + mid));
+	size_t a = 0, b = mid, out = 0, run = 0;
+
+	auto take = [&](t value)
+	{
+		if (out > 0 && !before(data[out - 1], value))
+		{
+			run++;
+			return;
+		}
+
+		if (out > 0) emit(data[out - 1], run);
+
+		stats->swaps++;
+
+		data[out++] = std::move(value);
+		run = 1;
+	};
+
+	while (a < mid && b < size)
+	{
+		if (before(data[b], left[a])) take(std::move(data[b++]));
+		else take(std::move(left[a++]));
+	}
+
+	while (a < mid) take(std::move(left[a++]));
+	while (b < size) take(std::move(data[b++]));
+
+	emit(data[out - 1], run);
+	data.resize(out);
+}
+
+template <class emit_t>
+void sort_aggregate(std::vector<int> &data, Comparator::Comparator comp, Stats* stats, emit_t emit, std::true_type)
+{
+	size_t size = data.size();
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	int min = data[0], max = data[0];
+	for (size_t i = 1; i < size; i++)
+	{
+		stats->compares++;
+
+		if (data[i] < min)
+		{
+			min = data[i];
+		}
+		else
+		{
+			stats->compares++;
+
+			if (data[i] > max) max = data[i];
+		}
+	}
+
+	size_t out = 0;
+	size_t range = (size_t)((long long)max - min);
+
+	// Narrow range, the histogram already holds the answer
+	if (counting_fits(range, size))
+	{
+		std::vector<uint32_t> count(range + 1, 0);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			count[(size_t)((long long)data[i] - min)]++;
+		}
+
+		for (size_t v = 0; v <= range; v++)
+		{
+			size_t bucket = (comp == Comparator::DECREASING) ? range - v : v;
+
+			if (count[bucket])
+			{
+				stats->swaps++;
+
+				data[out] = (int)(min + (long long)bucket);
+				emit(data[out++], count[bucket]);
+			}
+		}
+
+		data.resize(out);
+		return;
+	}
+
+	// Bytes above the highest one that differs between min and max are the same for every key
+	unsigned int differ = flag_key(min, comp) ^ flag_key(max, comp);
+	int passes = 0;
+	while (passes < 4 && (differ >> (8 * passes))) passes++;
+
+	// Four byte passes lose to the merge path, which gets to use the vectorized merges
+	if (passes == 4)
+	{
+		sort_aggregate(data, comp, stats, emit, std::false_type());
+		return;
+	}
+
+	std::vector<int> secondary(size);
+	std::vector<size_t> runs(size);
+	int* src = data.data();
+	int* dst = secondary.data();
+
+	for (int pass = 0; pass < passes; pass++)
+	{
+		int shift = 8 * pass;
+		bool last = pass + 1 == passes;
+		size_t next[256] = { 0 };
+
+		for (size_t i = 0; i < size; i++)
+		{
+			next[(flag_key(src[i], comp) >> shift) & 0xFF]++;
+		}
+
+		size_t start[256];
+		size_t sum = 0;
+		for (int b = 0; b < 256; b++)
+		{
+			start[b] = sum;
+			sum += next[b];
+			next[b] = start[b];
+		}
+
+		for (size_t i = 0; i < size; i++)
+		{
+			size_t b = (flag_key(src[i], comp) >> shift) & 0xFF;
+
+			// Every bucket receives its values in sorted order on the last pass, so an equal value
+			// can only be the one written right before it
+			if (last && next[b] > start[b])
+			{
+				stats->compares++;
+
+				if (dst[next[b] - 1] == src[i])
+				{
+					runs[next[b] - 1]++;
+					continue;
+				}
+			}
+
+			stats->swaps++;
+
+			dst[next[b]] = src[i];
+			runs[next[b]++] = 1;
+		}
+
+		if (last)
+		{
+			// Closes the gaps the collapsed values left behind, out never passes the read position
+			for (int b = 0; b < 256; b++)
+			{
+				for (size_t j = start[b]; j < next[b]; j++)
+				{
+					data[out] = dst[j];
+					emit(data[out++], runs[j]);
+				}
+			}
+		}
+
+		std::swap(src, dst);
+	}
+
+	data.resize(out);
+}
+
+// Sorts data and removes repeated values in the same passes
+template <class t>
+Stats* sort_unique(std::vector<t> &data, Comparator::Comparator comp)
+{
+	Stats* stats = new Stats();
+	stats->size = data.size();
+
+	sort_aggregate(data, comp, stats, [](const t &, size_t) {}, std::is_same<t, int>());
+
+	return stats;
+}
+
+// Sorts data into its distinct values and fills counts with every value and how often it occurred
+template <class t>
+Stats* sort_count(std::vector<t> &data, std::vector<std::pair<t, size_t>> &counts, Comparator::Comparator comp)
+{
+	Stats* stats = new Stats();
+	stats->size = data.size();
+
+	counts.clear();
+	sort_aggregate(data, comp, stats, [&counts](const t &value, size_t count) { counts.push_back({ value, count }); }, std::is_same<t, int>());
+
+	return stats;
+}
\ No newline at end of file
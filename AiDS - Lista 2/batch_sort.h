@@ -0,0 +1,222 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <climits>
+#include <algorithm>
+#include <type_traits>
+
+#include "sorting.h"
+
+#ifndef BATCH_NETWORK_MAX
+#define BATCH_NETWORK_MAX 64
+#endif
+
+// Compare-exchange pairs of Batcher's odd-even merge sort, size has to be a power of two
+inline std::vector<std::pair<int, int>> odd_even_network(int size)
+{
+	std::vector<std::pair<int, int>> network;
+
+	for (int p = 1; p < size; p *= 2)
+	{
+		for (int k = p; k >= 1; k /= 2)
+		{
+			for (int j = k % p; j + k < size; j += 2 * k)
+			{
+				for (int i = 0; i < std::min(k, size - j - k); i++)
+				{
+					if ((i + j) / (2 * p) == (i + j + k) / (2 * p))
+					{
+						network.push_back({ i + j, i + j + k });
+					}
+				}
+			}
+		}
+	}
+
+	return network;
+}
+
+// Network for the smallest power of two holding size elements
+inline const std::vector<std::pair<int, int>> &batch_network(size_t size)
+{
+	static const std::vector<std::vector<std::pair<int, int>>> networks = []()
+	{
+		std::vector<std::vector<std::pair<int, int>>> all;
+
+		for (int size = 1; size <= BATCH_NETWORK_MAX; size *= 2)
+		{
+			all.push_back(odd_even_network(size));
+		}
+
+		return all;
+	}();
+
+	size_t level = 0;
+	while (((size_t)1 << level) < size) level++;
+
+	return networks[level];
+}
+
+#if SIMD_MERGE
+
+// Runs the network over 8 arrays at once, lanes holds element k of every array at lanes[8 * k]
+template <bool desc>
+AVX2_TARGET void network_sort_8(int* lanes, const std::vector<std::pair<int, int>> &network)
+{
+	for (auto it = network.begin(); it != network.end(); it++)
+	{
+		int* a = lanes + 8 * it->first;
+		int* b = lanes + 8 * it->second;
+
+		__m256i x = Avx2Int::load(a);
+		__m256i y = Avx2Int::load(b);
+
+		Avx2Int::store(a, desc ? Avx2Int::max(x, y) : Avx2Int::min(x, y));
+		Avx2Int::store(b, desc ? Avx2Int::min(x, y) : Avx2Int::max(x, y));
+	}
+}
+
+// Sorts the listed arrays, all padding to the same network size, in groups of 8. Missing elements
+// are filled with a value that sorts last and dropped again afterwards.
+template <bool desc>
+void batch_network_sort(int* values, const size_t* offsets, const std::vector<size_t> &arrays, size_t width, Stats* stats)
+{
+	const std::vector<std::pair<int, int>> &network = batch_network(width);
+	std::vector<int> lanes(8 * width);
+	int pad = desc ? INT_MIN : INT_MAX;
+
+	for (size_t g = 0; g < arrays.size(); g += 8)
+	{
+		size_t count = std::min((size_t)8, arrays.size() - g);
+
+		for (size_t j = 0; j < 8; j++)
+		{
+			size_t lo = (j < count) ? offsets[arrays[g + j]] : 0;
+			size_t n = (j < count) ? offsets[arrays[g + j] + 1] - lo : 0;
+
+			for (size_t k = 0; k < width; k++)
+			{
+				lanes[8 * k + j] = (k < n) ? values[lo + k] : pad;
+			}
+		}
+
+		network_sort_8<desc>(lanes.data(), network);
+
+		for (size_t j = 0; j < count; j++)
+		{
+			size_t lo = offsets[arrays[g + j]];
+			size_t n = offsets[arrays[g + j] + 1] - lo;
+
+			for (size_t k = 0; k < n; k++)
+			{
+				values[lo + k] = lanes[8 * k + j];
+			}
+		}
+
+		stats->compares += (long long)network.size() * count;
+	}
+}
+
+#endif
+
+template <class t>
+void batch_sort_arrays(std::vector<t> &values, const std::vector<size_t> &offsets, size_t lo, size_t hi, Comparator::Comparator comp, Stats* stats, std::false_type)
+{
+	for (size_t a = lo; a < hi; a++)
+	{
+		size_t n = offsets[a + 1] - offsets[a];
+
+		if (n <= BATCH_NETWORK_MAX)
+		{
+			insertion_blocks(values.begin() + offsets[a], n, n, comp, stats);
+		}
+		else
+		{
+			Stats* s = hybrid_sort(values.begin() + offsets[a], values.begin() + offsets[a + 1], comp);
+			add_stats(stats, *s);
+			delete s;
+		}
+	}
+}
+
+#if SIMD_MERGE
+
+template <class t>
+void batch_sort_arrays(std::vector<t> &values, const std::vector<size_t> &offsets, size_t lo, size_t hi, Comparator::Comparator comp, Stats* stats, std::true_type)
+{
+	if (!simd_merge_enabled())
+	{
+		batch_sort_arrays(values, offsets, lo, hi, comp, stats, std::false_type());
+		return;
+	}
+
+	// Arrays grouped by the network size they need, everything longer goes through the usual path
+	std::vector<std::vector<size_t>> widths;
+	for (size_t a = lo; a < hi; a++)
+	{
+		size_t n = offsets[a + 1] - offsets[a];
+
+		if (n < 2) continue;
+
+		if (n > BATCH_NETWORK_MAX)
+		{
+			batch_sort_arrays(values, offsets, a, a + 1, comp, stats, std::false_type());
+			continue;
+		}
+
+		size_t level = 0;
+		while (((size_t)1 << level) < n) level++;
+
+		if (widths.size() <= level) widths.resize(level + 1);
+		widths[level].push_back(a);
+	}
+
+	for (size_t level = 0; level < widths.size(); level++)
+	{
+		if (comp == Comparator::DECREASING)
+		{
+			batch_network_sort<true>(values.data(), offsets.data(), widths[level], (size_t)1 << level, stats);
+		}
+		else
+		{
+			batch_network_sort<false>(values.data(), offsets.data(), widths[level], (size_t)1 << level, stats);
+		}
+	}
+}
+
+#endif
+
+// Sorts every array of a CSR layout, array a being values[offsets[a] .. offsets[a + 1]). Small int arrays
+// go through sorting networks 8 arrays per vector, the arrays are split between threads and one Stats
+// covers the whole batch, so there is no per-array allocation.
+template <class t>
+Stats* batch_sort(std::vector<t> &values, const std::vector<size_t> &offsets, Comparator::Comparator comp, size_t threads = SAMPLE_THREADS)
+{
+	Stats* stats = new Stats();
+	stats->size = values.size();
+	size_t arrays = offsets.empty() ? 0 : offsets.size() - 1;
+
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	threads = std::max((size_t)1, std::min(threads, arrays / 1024));
+	size_t chunk = (arrays + threads - 1) / threads;
+	std::vector<Stats> thread_stats(threads, Stats{ 0, 0, 0, 0.0 });
+
+	run_parallel(threads, [&](size_t id)
+	{
+		size_t lo = std::min(arrays, id * chunk), hi = std::min(arrays, lo + chunk);
+
+		batch_sort_arrays(values, offsets, lo, hi, comp, &thread_stats[id], std::integral_constant<bool, SIMD_MERGE && std::is_same<t, int>::value>());
+	});
+
+	for (auto it = thread_stats.begin(); it != thread_stats.end(); it++)
+	{
+		add_stats(stats, *it);
+	}
+
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <fstream>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#define DEFAULT_L1_CACHE_SIZE (32 * 1024)
+#define DEFAULT_L2_CACHE_SIZE (256 * 1024)
+
+#if defined(__linux__)
+// Looks the data or unified cache of the given level up in /sys, returns 0 when it is not listed
+inline size_t sys_cache_size(int level)
+{
+	for (int index = 0; index < 8; index++)
+	{
+		std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+		std::ifstream level_file(dir + "level"), type_file(dir + "type"), size_file(dir + "size");
+
+		int cache_level;
+		std::string type, size;
+
+		if (!(level_file >> cache_level) || !(type_file >> type) || !(size_file >> size))
+		{
+			break;
+		}
+
+		if (cache_level != level || type == "Instruction")
+		{
+			continue;
+		}
+
+		size_t bytes = std::stoul(size);
+
+		switch (size.back())
+		{
+		case 'K':
+			return bytes * 1024;
+		case 'M':
+			return bytes * 1024 * 1024;
+		default:
+			return bytes;
+		}
+	}
+
+	return 0;
+}
+#endif
+
+inline size_t detect_cache_size(int level)
+{
+	long bytes = 0;
+
+#if defined(__linux__) && defined(_SC_LEVEL1_DCACHE_SIZE)
+	bytes = sysconf((level == 1) ? _SC_LEVEL1_DCACHE_SIZE : _SC_LEVEL2_CACHE_SIZE);
+#endif
+
+#if defined(__linux__)
+	if (bytes <= 0)
+	{
+		bytes = (long)sys_cache_size(level);
+	}
+#endif
+
+	if (bytes <= 0)
+	{
+		bytes = (level == 1) ? DEFAULT_L1_CACHE_SIZE : DEFAULT_L2_CACHE_SIZE;
+	}
+
+	return (size_t)bytes;
+}
+
+// Size in bytes of the L1 data cache (level 1) or the L2 cache (level 2), detected once
+inline size_t cache_size(int level)
+{
+	static const size_t l1 = detect_cache_size(1);
+	static const size_t l2 = detect_cache_size(2);
+
+	return (level == 1) ? l1 : l2;
+}
\ No newline at end of file
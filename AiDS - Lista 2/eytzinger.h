@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "sorting.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+inline void prefetch(const void* p)
+{
+#if defined(_MSC_VER)
+	_mm_prefetch((const char*)p, _MM_HINT_T0);
+#else
+	__builtin_prefetch(p);
+#endif
+}
+
+inline int trailing_ones(uint64_t k)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, ~k);
+	return (int)index;
+#elif defined(_MSC_VER)
+	int count = 0;
+	while (k & 1) { k >>= 1; count++; }
+	return count;
+#else
+	return __builtin_ctzll(~k);
+#endif
+}
+
+// Sorted data rearranged in Eytzinger (BFS) order: the root at slot 1 and the children of slot k at
+// 2k and 2k + 1. A search walks down the slots without branching on the compares, and the 16 (for
+// 4 byte keys) descendants four levels below k share one cache line, so that line is prefetched
+// while the next levels are compared. Plain binary search jumps across the whole array on the first
+// levels and misses the cache on nearly every one of them.
+template <class t>
+class EytzingerLayout
+{
+public:
+	EytzingerLayout(const std::vector<t> &sorted, Comparator::Comparator comp) : n(sorted.size()), comp(comp)
+	{
+		// Slot 0 is never looked at, the padding lets the first slot of every prefetched block start a line
+		storage.resize(n + 1 + line);
+		shift = 0;
+
+		if (CACHE_LINE % sizeof(t) == 0)
+		{
+			size_t skew = (size_t)((uintptr_t)storage.data() % CACHE_LINE);
+			shift = skew ? (CACHE_LINE - skew) / sizeof(t) : 0;
+		}
+
+		fill(sorted, 0, 1);
+	}
+
+	// Slot of the first element that does not go before value, 0 when there is none
+	size_t lower_bound(const t &value) const
+	{
+		if (comp == Comparator::DECREASING)
+		{
+			return search<DecreasingOrder>(value);
+		}
+
+		return search<IncreasingOrder>(value);
+	}
+
+	bool contains(const t &value) const
+	{
+		size_t slot = lower_bound(value);
+		return slot != 0 && slots()[slot] == value;
+	}
+
+	const t &operator[](size_t slot) const
+	{
+		return slots()[slot];
+	}
+
+	size_t size() const
+	{
+		return n;
+	}
+
+private:
+	static const size_t line = CACHE_LINE / sizeof(t) ? CACHE_LINE / sizeof(t) : 1;
+
+	size_t n;
+	Comparator::Comparator comp;
+	std::vector<t> storage;
+
+	// Kept as an offset rather than a pointer so copies and moves of the layout stay valid, a copy may
+	// lose the line alignment but not the contents
+	size_t shift;
+
+	const t* slots() const
+	{
+		return storage.data() + shift;
+	}
+
+	// In-order walk of the implicit tree, the i-th visited slot gets the i-th sorted element
+	size_t fill(const std::vector<t> &sorted, size_t i, size_t k)
+	{
+		if (k <= n)
+		{
+			i = fill(sorted, i, 2 * k);
+			storage[shift + k] = sorted[i++];
+			i = fill(sorted, i, 2 * k + 1);
+		}
+
+		return i;
+	}
+
+	template <class order>
+	size_t search(const t &value) const
+	{
+		const t* base = slots();
+		uint64_t k = 1;
+
+		while (k <= n)
+		{
+			prefetch(base + k * line);
+			k = 2 * k + order::before(base[k], value);
+		}
+
+		// The answer is where the walk last went left, drop the right turns after it and that left turn
+		k >>= trailing_ones(k) + 1;
+
+		return (size_t)k;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <stack>
+#include <iterator>
+
+#include "sorting.h"
+#include "selection.h"
+
+#ifndef INCREMENTAL_CUT_OFF
+#define INCREMENTAL_CUT_OFF 16
+#endif
+
+// Sorted view of a vector that only sorts as far as it is read (incremental quicksort).
+// The stack holds the ranges already in their final place, nearest one on top, and whatever lies
+// between the read position and the top is partitioned only when the next element is asked for,
+// so each element costs O(log n) amortized and the first page comes out long before a full sort would.
+template <class t>
+class IncrementalSort
+{
+public:
+	class iterator
+	{
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef t value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const t* pointer;
+		typedef const t& reference;
+
+		iterator(IncrementalSort* view, size_t index) : view(view), index(index) {}
+
+		const t& operator*() const { return view->at(index); }
+		const t* operator->() const { return &view->at(index); }
+
+		iterator& operator++()
+		{
+			index++;
+			return *this;
+		}
+
+		bool operator==(const iterator &other) const { return index == other.index; }
+		bool operator!=(const iterator &other) const { return index != other.index; }
+
+	private:
+		IncrementalSort* view;
+		size_t index;
+	};
+
+	IncrementalSort(std::vector<t> &data, Comparator::Comparator comp) : data(data), comp(comp), read(0), counters{ data.size(), 0, 0, 0.0 }
+	{
+		sorted.push({ data.size(), data.size() });
+	}
+
+	bool done() const { return read >= data.size(); }
+
+	// Number of elements already handed out, all of them are in their final place
+	size_t position() const { return read; }
+
+	// Next element in sorted order, must not be called once done()
+	const t& next()
+	{
+		Span top = sorted.top();
+
+		while (read < top.begin)
+		{
+			size_t size = top.begin - read;
+
+			if (size <= INCREMENTAL_CUT_OFF)
+			{
+				insertion_blocks(data.begin() + read, size, size, comp, &counters);
+				top = { read, top.begin };
+			}
+			else
+			{
+				// Three way, so runs of equal keys come out in one step instead of one pivot at a time
+				t pivot = data[read + rand() % size];
+
+				size_t lt, gt;
+				partition_three_way(data.begin(), comp, &counters, Range{ read, top.begin - 1 }, pivot, lt, gt);
+				top = { lt, gt };
+			}
+
+			sorted.push(top);
+		}
+
+		const t& value = data[read++];
+
+		if (read >= top.end)
+		{
+			sorted.pop();
+		}
+
+		return value;
+	}
+
+	// Element at index in sorted order, sorting up to it if it has not been reached yet
+	const t& at(size_t index)
+	{
+		while (read <= index)
+		{
+			next();
+		}
+
+		return data[index];
+	}
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, data.size()); }
+
+	const Stats& stats() const { return counters; }
+
+private:
+	// Half-open [begin, end), unlike the inclusive Range the partitions take
+	struct Span
+	{
+		size_t begin, end;
+	};
+
+	std::vector<t> &data;
+	Comparator::Comparator comp;
+	size_t read;
+	Stats counters;
+	std::stack<Span> sorted;
+};
\ No newline at end of file
@@ -6,6 +6,15 @@
 #include <sstream>
 
 #include "sorting.h"
+#include "string_sorting.h"
+#include "string_pool.h"
+#include "process_sort.h"
+#include "batch_sort.h"
+#include "selection.h"
+#include "incremental_sort.h"
+#include "sorted_accumulator.h"
+#include "semisort.h"
+#include "eytzinger.h"
 
 #define MAX_VALUE 2100000000
 
@@ -27,6 +36,19 @@ void parse_params(int argc, char* argv[], SortType::SortType &type, Comparator::
 				else if (std::string(argv[i]) == "hybrid") type = SortType::HYBRID;
 				else if (std::string(argv[i]) == "dual") type = SortType::DUAL;
 				else if (std::string(argv[i]) == "radix") type = SortType::RADIX;
+				else if (std::string(argv[i]) == "prefix") type = SortType::PREFIX;
+				else if (std::string(argv[i]) == "lcp") type = SortType::LCP;
+				else if (std::string(argv[i]) == "dict") type = SortType::DICT;
+				else if (std::string(argv[i]) == "multiway") type = SortType::MULTIWAY;
+				else if (std::string(argv[i]) == "flag") type = SortType::FLAG;
+				else if (std::string(argv[i]) == "sample") type = SortType::SAMPLE;
+				else if (std::string(argv[i]) == "process") type = SortType::PROCESS;
+				else if (std::string(argv[i]) == "binary") type = SortType::BINARY;
+				else if (std::string(argv[i]) == "merge_insert") type = SortType::MERGE_INSERT;
+				else if (std::string(argv[i]) == "auto") type = SortType::AUTO;
+				else if (std::string(argv[i]) == "heap") type = SortType::HEAP;
+				else if (std::string(argv[i]) == "intro") type = SortType::INTRO;
+				else if (std::string(argv[i]) == "block") type = SortType::BLOCK;
 			}
 			else
 			{
@@ -73,11 +95,11 @@ void generate_csv(std::vector<Stats*> &res, std::string file_name)
 	std::ofstream file;
 	file.open(file_name);
 
-	file << "\"size\";\"compares\";\"swaps\";\"time\"\n";
+	file << "\"size\";\"compares\";\"swaps\";\"time\";\"characters\";\"encode_compares\"\n";
 
 	for (size_t i = 0; i < res.size(); i++)
 	{
-		file << res[i]->size << ";" << res[i]->compares << ";" << res[i]->swaps << ";" << time_to_str(res[i]->time, 2) << "\n";
+		file << res[i]->size << ";" << res[i]->compares << ";" << res[i]->swaps << ";" << time_to_str(res[i]->time, 2) << ";" << res[i]->characters << ";" << res[i]->encode_compares << "\n";
 	}
 
 	file.close();
@@ -100,11 +122,29 @@ void generate_data(std::vector<std::string> &data, int count)
 
 	for (int j = 0; j < count; j++)
 	{
-		std::stringstream ss;
+		std::string str(50, ' ');
 		for (int i = 0; i < 50; ++i) {
-			ss << alphanum[rand() % (sizeof(alphanum) - 1)];
+			str[i] = alphanum[rand() % (sizeof(alphanum) - 1)];
+		}
+		data.push_back(std::move(str));
+	}
+}
+
+void generate_data(StringPool &data, int count)
+{
+	static const char alphanum[] =
+		"0123456789"
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+		"abcdefghijklmnopqrstuvwxyz";
+
+	data.reserve(data.size() + count);
+
+	for (int j = 0; j < count; j++)
+	{
+		char* str = data.allocate(50);
+		for (int i = 0; i < 50; ++i) {
+			str[i] = alphanum[rand() % (sizeof(alphanum) - 1)];
 		}
-		data.push_back(ss.str());
 	}
 }
 
@@ -123,15 +163,89 @@ void get_data(std::vector<t> &data)
 	}
 }
 
+std::vector<Stats*> average_results(std::vector<Stats*> &results, int k)
+{
+	std::vector<Stats*> avg_res(results.size() / k);
+	for (size_t i = 1; i <= results.size() / k; i++)
+	{
+		Stats* s = new Stats;
+		s->size = results[(i - 1) * k]->size;
+		s->compares = 0;
+		s->swaps = 0;
+		s->time = 0;
+		s->characters = 0;
+		s->encode_compares = 0;
+
+		for (int j = 0; j < k; j++)
+		{
+			s->compares += results[(i - 1) * k + j]->compares;
+			s->swaps += results[(i - 1) * k + j]->swaps;
+			s->time += results[(i - 1) * k + j]->time;
+			s->characters += results[(i - 1) * k + j]->characters;
+			s->encode_compares += results[(i - 1) * k + j]->encode_compares;
+		}
+
+		s->compares /= k;
+		s->swaps /= k;
+		s->time /= k;
+		s->characters /= k;
+		s->encode_compares /= k;
+
+		avg_res[i - 1] = s;
+	}
+
+	return avg_res;
+}
+
+// Writes the averages of every k results to the csv and frees all of them
+void save_results(std::vector<Stats*> &results, int k, std::string file_name)
+{
+	std::vector<Stats*> avg_res = average_results(results, k);
+	generate_csv(avg_res, file_name);
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		delete results[i];
+	}
+
+	for (size_t i = 0; i < avg_res.size(); i++)
+	{
+		delete avg_res[i];
+	}
+
+	results.clear();
+}
+
+void get_data(StringPool &data)
+{
+	int n;
+	std::string str;
+
+	std::cin >> n;
+	data.reserve(n);
+
+	for (int i = 0; i < n; i++)
+	{
+		std::cin >> str;
+		data.add(str);
+	}
+}
+
 void multiple_test(SortType::SortType &type, Comparator::Comparator &comp, std::string file_name, int &k)
 {
 	std::clock_t start, end;
 	std::vector<Stats*> results;
 	std::vector<int> data;
-	std::function<Stats* (std::vector<int> &, Comparator::Comparator)> sort_algo = nullptr;
+	Stats* (*sort_algo)(std::vector<int> &, Comparator::Comparator) = nullptr;
 
 	switch (type)
 	{
+	// Nothing to sort here, the string only types go to the string tests
+	case SortType::NONE:
+	case SortType::PREFIX:
+	case SortType::LCP:
+	case SortType::DICT:
+		break;
 	case SortType::INSERT:
 		sort_algo = insertion_sort<int>;
 		break;
@@ -150,6 +264,36 @@ void multiple_test(SortType::SortType &type, Comparator::Comparator &comp, std::
 	case SortType::RADIX:
 		sort_algo = radix_sort;
 		break;
+	case SortType::MULTIWAY:
+		sort_algo = [](std::vector<int> &data, Comparator::Comparator comp) { return multiway_merge_sort(data, comp); };
+		break;
+	case SortType::FLAG:
+		sort_algo = american_flag_sort;
+		break;
+	case SortType::SAMPLE:
+		sort_algo = [](std::vector<int> &data, Comparator::Comparator comp) { return sample_sort(data, comp); };
+		break;
+	case SortType::PROCESS:
+		sort_algo = [](std::vector<int> &data, Comparator::Comparator comp) { return process_sort(data, comp); };
+		break;
+	case SortType::BINARY:
+		sort_algo = binary_insertion_sort<int>;
+		break;
+	case SortType::MERGE_INSERT:
+		sort_algo = merge_insertion_sort<int>;
+		break;
+	case SortType::AUTO:
+		sort_algo = auto_sort<int>;
+		break;
+	case SortType::HEAP:
+		sort_algo = heap_sort<int>;
+		break;
+	case SortType::INTRO:
+		sort_algo = intro_sort<int>;
+		break;
+	case SortType::BLOCK:
+		sort_algo = block_merge_sort<int>;
+		break;
 	}
 
 	size_t size = 10;
@@ -181,30 +325,45 @@ void multiple_test(SortType::SortType &type, Comparator::Comparator &comp, std::
 		}
 	}
 
-	std::vector<Stats*> avg_res(results.size() / k);
-	for (int i = 1; i <= results.size() / k; i++)
+	save_results(results, k, file_name);
+}
+
+void multiple_string_test(SortType::SortType &type, Comparator::Comparator &comp, std::string file_name, int &k)
+{
+	std::clock_t start, end;
+	std::vector<Stats*> results;
+	StringPool data;
+
+	size_t size = 10;
+	for (int i = 0; i < 9; i++)
 	{
-		Stats* s = new Stats;
-		s->size = results[(i - 1) * k]->size;
-		s->compares = 0;
-		s->swaps = 0;
-		s->time = 0;
+		std::cerr << "Current size = " << size << std::endl;
 
-		for (int j = 0; j < k; j++)
+		for (int i = 0; i < k; i++)
 		{
-			s->compares += results[(i - 1) * k + j]->compares;
-			s->swaps += results[(i - 1) * k + j]->swaps;
-			s->time += results[(i - 1) * k + j]->time;
-		}
+			generate_data(data, size);
 
-		s->compares /= k;
-		s->swaps /= k;
-		s->time /= k;
+			start = std::clock();
+			Stats* s = sort_strings(data.begin(), data.end(), comp, type);
+			end = std::clock();
 
-		avg_res[i - 1] = s;
+			data.clear();
+
+			s->time = (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			results.push_back(s);
+		}
+
+		if (i % 2 == 0)
+		{
+			size *= 5;
+		}
+		else
+		{
+			size *= 2;
+		}
 	}
 
-	generate_csv(avg_res, file_name);
+	save_results(results, k, file_name);
 }
 
 template <class t>
@@ -223,6 +382,12 @@ void single_test(SortType::SortType &type, Comparator::Comparator &comp)
 
 		switch (type)
 		{
+		// Nothing to sort here, the string only types go to the string tests
+		case SortType::NONE:
+		case SortType::PREFIX:
+		case SortType::LCP:
+		case SortType::DICT:
+			break;
 		case SortType::INSERT:
 			stats = insertion_sort<t>(data, comp);
 			break;
@@ -241,6 +406,36 @@ void single_test(SortType::SortType &type, Comparator::Comparator &comp)
 		case SortType::RADIX:
 			stats = radix_sort(data, comp);
 			break;
+		case SortType::MULTIWAY:
+			stats = multiway_merge_sort<t>(data, comp);
+			break;
+		case SortType::FLAG:
+			stats = american_flag_sort(data, comp);
+			break;
+		case SortType::SAMPLE:
+			stats = sample_sort<t>(data, comp);
+			break;
+		case SortType::PROCESS:
+			stats = process_sort<t>(data, comp);
+			break;
+		case SortType::BINARY:
+			stats = binary_insertion_sort<t>(data, comp);
+			break;
+		case SortType::MERGE_INSERT:
+			stats = merge_insertion_sort<t>(data, comp);
+			break;
+		case SortType::AUTO:
+			stats = auto_sort<t>(data, comp);
+			break;
+		case SortType::HEAP:
+			stats = heap_sort<t>(data, comp);
+			break;
+		case SortType::INTRO:
+			stats = intro_sort<t>(data, comp);
+			break;
+		case SortType::BLOCK:
+			stats = block_merge_sort<t>(data, comp);
+			break;
 		}
 
 		end = std::clock();
@@ -268,17 +463,76 @@ void single_test(SortType::SortType &type, Comparator::Comparator &comp)
 	}
 }
 
+void single_string_test(SortType::SortType &type, Comparator::Comparator &comp)
+{
+	std::clock_t start, end;
+	Stats* stats = nullptr;
+	StringPool data;
+
+	// get_data(data);
+	generate_data(data, 15);
+
+	if (type != SortType::NONE && comp != Comparator::NONE)
+	{
+		start = std::clock();
+		stats = sort_strings(data.begin(), data.end(), comp, type);
+		end = std::clock();
+
+		if (!range_sorted(data.begin(), data.end(), comp))
+		{
+			std::cerr << "Sorting failed!" << std::endl;
+		}
+	}
+	else
+	{
+		print_usage();
+	}
+
+	if (stats)
+	{
+		std::cerr << "Compares = " << stats->compares << "; Swaps = " << stats->swaps << "; Time = " << (end - start) / (double)(CLOCKS_PER_SEC / 1000.0) << "ms" << std::endl;
+		std::cout << "Size = " << stats->size << std::endl;
+
+		for (auto it = data.begin(); it != data.end(); it++)
+		{
+			std::cout << *it << " ";
+		}
+		std::cout << std::endl;
+
+		delete stats;
+	}
+}
+
+bool string_type(SortType::SortType type)
+{
+	return type == SortType::PREFIX || type == SortType::LCP || type == SortType::DICT;
+}
+
 void run_test(SortType::SortType &type, Comparator::Comparator &comp, std::string file_name, int &k)
 {
 	std::srand((unsigned int)time(NULL));
 
 	if (k > 0)
 	{
-		multiple_test(type, comp, file_name, k);
+		if (string_type(type))
+		{
+			multiple_string_test(type, comp, file_name, k);
+		}
+		else
+		{
+			multiple_test(type, comp, file_name, k);
+		}
 	}
 	else
 	{
-		single_test<int>(type, comp);
+		if (string_type(type))
+		{
+			single_string_test(type, comp);
+		}
+		else
+		{
+			single_test<int>(type, comp);
+		}
 	}
 }
 
@@ -288,7 +542,7 @@ void test_cut_off(std::string file_name, int &k)
 	std::clock_t start, end;
 	std::vector<Stats*> results;
 	std::vector<t> data;
-	auto sort_algo = hybrid_sort_test<t>;
+	Stats* (*sort_algo)(std::vector<t> &, Comparator::Comparator, size_t) = hybrid_sort_test<t>;
 	size_t size = 10000;
 
 	size_t min_cut = 1;
@@ -321,17 +575,23 @@ void test_cut_off(std::string file_name, int &k)
 		s->compares = 0;
 		s->swaps = 0;
 		s->time = 0;
+		s->characters = 0;
+		s->encode_compares = 0;
 
 		for (int j = 0; j < k; j++)
 		{
 			s->compares += results[(i - 1) * k + j]->compares;
 			s->swaps += results[(i - 1) * k + j]->swaps;
 			s->time += results[(i - 1) * k + j]->time;
+			s->characters += results[(i - 1) * k + j]->characters;
+			s->encode_compares += results[(i - 1) * k + j]->encode_compares;
 		}
 
 		s->compares /= k;
 		s->swaps /= k;
 		s->time /= k;
+		s->characters /= k;
+		s->encode_compares /= k;
 
 		avg_res[i - 1] = s;
 	}
@@ -349,6 +609,313 @@ void test_cut_off(std::string file_name, int &k)
 	}
 }
 
+template <class t>
+void test_ways(std::string file_name, int &k)
+{
+	std::clock_t start, end;
+	std::vector<Stats*> results;
+	std::vector<t> data;
+	size_t size = 1000000;
+
+	for (size_t ways = 2; ways <= 64; ways *= 2)
+	{
+		std::cerr << "Current ways = " << ways << std::endl;
+
+		for (int i = 0; i < k; i++)
+		{
+			generate_data(data, size);
+
+			start = std::clock();
+			Stats* s = multiway_merge_sort(data, Comparator::Comparator::INCREASING, ways);
+			end = std::clock();
+
+			data.clear();
+
+			s->time = (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			s->size = ways;
+			results.push_back(s);
+		}
+	}
+
+	save_results(results, k, file_name);
+}
+
+// Sorts batches of arrays of length 8 to 64, size in the csv is the array length and arrays
+// per second come out as arrays / time
+void test_batch(std::string file_name, int &k)
+{
+	std::clock_t start, end;
+	std::vector<Stats*> results;
+	std::vector<int> data;
+	std::vector<size_t> offsets;
+	size_t arrays = 100000;
+
+	for (size_t length = 8; length <= 64; length *= 2)
+	{
+		std::cerr << "Current length = " << length << std::endl;
+
+		for (int i = 0; i < k; i++)
+		{
+			generate_data(data, arrays * length);
+
+			offsets.clear();
+			for (size_t a = 0; a <= arrays; a++)
+			{
+				offsets.push_back(a * length);
+			}
+
+			start = std::clock();
+			Stats* s = batch_sort(data, offsets, Comparator::Comparator::INCREASING);
+			end = std::clock();
+
+			data.clear();
+
+			s->time = (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			s->size = length;
+			results.push_back(s);
+		}
+
+		std::cerr << "Arrays per second = " << arrays / (results.back()->time / 1000.0) << std::endl;
+	}
+
+	save_results(results, k, file_name);
+}
+
+// Top k of a million elements for k from 10 to 100000, size in the csv is k
+void test_top_k(std::string file_name, int &k, Stats* (*select_algo)(std::vector<int> &, size_t, Comparator::Comparator))
+{
+	std::clock_t start, end;
+	std::vector<Stats*> results;
+	std::vector<int> data;
+	size_t size = 1000000;
+
+	for (size_t top = 10; top <= 100000; top *= 10)
+	{
+		std::cerr << "Current k = " << top << std::endl;
+
+		for (int i = 0; i < k; i++)
+		{
+			generate_data(data, size);
+
+			start = std::clock();
+			Stats* s = select_algo(data, top, Comparator::Comparator::INCREASING);
+			end = std::clock();
+
+			data.clear();
+
+			s->time = (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			s->size = top;
+			results.push_back(s);
+		}
+	}
+
+	save_results(results, k, file_name);
+}
+
+// Time to the first 1, 10, ..., all elements of an incremental sort of a million elements, size in the
+// csv is the number of elements taken. The full hybrid sort time of the same data goes to stderr.
+void test_incremental(std::string file_name, int &k)
+{
+	std::clock_t start, end;
+	std::vector<Stats*> results;
+	std::vector<int> data;
+	size_t size = 1000000;
+	double full_time = 0;
+
+	for (size_t taken = 1; taken <= size; taken *= 10)
+	{
+		std::cerr << "Current taken = " << taken << std::endl;
+
+		for (int i = 0; i < k; i++)
+		{
+			generate_data(data, size);
+			std::vector<int> copy = data;
+
+			start = std::clock();
+			IncrementalSort<int> view(data, Comparator::Comparator::INCREASING);
+			for (size_t j = 0; j < taken; j++)
+			{
+				view.next();
+			}
+			end = std::clock();
+
+			Stats* s = new Stats(view.stats());
+			s->time = (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			s->size = taken;
+			results.push_back(s);
+
+			start = std::clock();
+			delete hybrid_sort(copy, Comparator::Comparator::INCREASING);
+			end = std::clock();
+
+			full_time += (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			data.clear();
+		}
+	}
+
+	std::cerr << "Full sort time = " << full_time / results.size() << std::endl;
+
+	save_results(results, k, file_name);
+}
+
+// Batches of 10000 elements arrive and a sorted copy is needed after each one, either by sorting
+// everything again or through a SortedAccumulator. Size in the csv is the number of elements in the end.
+void test_accumulator(std::string file_name, int &k, bool use_accumulator)
+{
+	std::clock_t start, end;
+	std::vector<Stats*> results;
+	std::vector<int> data;
+	size_t batch = 10000;
+
+	for (size_t batches = 10; batches <= 100; batches += 10)
+	{
+		std::cerr << "Current batches = " << batches << std::endl;
+
+		for (int i = 0; i < k; i++)
+		{
+			generate_data(data, batches * batch);
+			Stats* s = new Stats{ data.size(), 0, 0, 0.0 };
+
+			start = std::clock();
+			if (use_accumulator)
+			{
+				SortedAccumulator<int> accumulator(Comparator::Comparator::INCREASING);
+				SortedAccumulator<int>::Producer producer = accumulator.producer();
+
+				for (size_t b = 0; b < batches; b++)
+				{
+					for (size_t j = b * batch; j < (b + 1) * batch; j++)
+					{
+						producer.add(data[j]);
+					}
+
+					producer.flush();
+					accumulator.snapshot();
+				}
+
+				Stats counters = accumulator.stats();
+				s->compares = counters.compares;
+				s->swaps = counters.swaps;
+			}
+			else
+			{
+				std::vector<int> sorted;
+
+				for (size_t b = 0; b < batches; b++)
+				{
+					sorted.insert(sorted.end(), data.begin() + b * batch, data.begin() + (b + 1) * batch);
+
+					Stats* step = hybrid_sort(sorted, Comparator::Comparator::INCREASING);
+					s->compares += step->compares;
+					s->swaps += step->swaps;
+					delete step;
+				}
+			}
+			end = std::clock();
+
+			data.clear();
+
+			s->time = (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			results.push_back(s);
+		}
+	}
+
+	save_results(results, k, file_name);
+}
+
+void test_group(std::string file_name, int &k, Stats* (*group_algo)(std::vector<int> &, Comparator::Comparator))
+{
+	std::clock_t start, end;
+	std::vector<Stats*> results;
+	std::vector<int> data;
+	size_t size = 1000000;
+
+	// Duplicate heavy inputs, only the grouping of equal keys is needed
+	for (int distinct = 10; distinct <= 1000000; distinct *= 10)
+	{
+		std::cerr << "Current distinct = " << distinct << std::endl;
+
+		for (int i = 0; i < k; i++)
+		{
+			data.resize(size);
+			for (size_t j = 0; j < size; j++)
+			{
+				data[j] = rand() % distinct;
+			}
+
+			start = std::clock();
+			Stats* s = group_algo(data, Comparator::Comparator::INCREASING);
+			end = std::clock();
+
+			data.clear();
+
+			s->time = (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			s->size = distinct;
+			results.push_back(s);
+		}
+	}
+
+	save_results(results, k, file_name);
+}
+
+void test_layout(std::string file_name, int &k, bool use_layout)
+{
+	std::clock_t start, end;
+	std::vector<Stats*> results;
+	std::vector<int> data, queries;
+	size_t lookups = 1000000;
+
+	for (size_t size = 1000; size <= 10000000; size *= 10)
+	{
+		std::cerr << "Current size = " << size << std::endl;
+
+		for (int i = 0; i < k; i++)
+		{
+			generate_data(data, size);
+			generate_data(queries, lookups);
+			std::sort(data.begin(), data.end());
+
+			EytzingerLayout<int> layout(data, Comparator::Comparator::INCREASING);
+			size_t found = 0;
+
+			start = std::clock();
+			if (use_layout)
+			{
+				for (size_t j = 0; j < lookups; j++)
+				{
+					found += layout.lower_bound(queries[j]) != 0;
+				}
+			}
+			else
+			{
+				for (size_t j = 0; j < lookups; j++)
+				{
+					found += std::lower_bound(data.begin(), data.end(), queries[j]) != data.end();
+				}
+			}
+			end = std::clock();
+
+			// A lookup finds an element exactly when the query is not above the maximum, checking the
+			// count also keeps the loops above from being optimized out
+			size_t expected = std::count_if(queries.begin(), queries.end(), [&](int query) { return query <= data.back(); });
+
+			if (found != expected)
+			{
+				std::cerr << "Lookup failed!" << std::endl;
+			}
+
+			data.clear();
+			queries.clear();
+
+			Stats* s = new Stats{ size, 0, 0, 0.0 };
+			s->time = (end - start) / (double)(CLOCKS_PER_SEC / 1000.0);
+			results.push_back(s);
+		}
+	}
+
+	save_results(results, k, file_name);
+}
+
 int main(int argc, char* argv[])
 {
 	if (argc < 5)
@@ -377,8 +944,39 @@ int main(int argc, char* argv[])
 	run_test(type, comp, "hybrid_500_2100000000.csv", k);
 	type = SortType::RADIX;
 	run_test(type, comp, "radix_500_2100000000.csv", k);
+	// type = SortType::FLAG;
+	// run_test(type, comp, "flag_500_2100000000.csv", k);
+	// type = SortType::SAMPLE;
+	// run_test(type, comp, "sample_500_2100000000.csv", k);
+	// type = SortType::PROCESS;
+	// run_test(type, comp, "process_500_2100000000.csv", k);
+	// type = SortType::HEAP;
+	// run_test(type, comp, "heap_500_2100000000.csv", k);
+	// type = SortType::BLOCK;
+	// run_test(type, comp, "block_500_2100000000.csv", k);
+
+	// type = SortType::PREFIX;
+	// multiple_string_test(type, comp, "prefix_500_string.csv", k);
+	// type = SortType::LCP;
+	// multiple_string_test(type, comp, "lcp_500_string.csv", k);
+	// type = SortType::DICT;
+	// multiple_string_test(type, comp, "dict_500_string.csv", k);
 
 	// k = 500;
 	// test_cut_off<std::string>("cut_off_string.csv", k);
 	// test_cut_off<int>("cut_off_int.csv", k);
+
+	// k = 10;
+	// test_ways<int>("ways_int.csv", k);
+	// test_batch("batch_int.csv", k);
+	// test_top_k("top_k_partial.csv", k, partial_quick_sort<int>);
+	// test_top_k("top_k_heap.csv", k, heap_top_k<int>);
+	// test_incremental("incremental_int.csv", k);
+	// test_accumulator("resort_int.csv", k, false);
+	// test_accumulator("accumulator_int.csv", k, true);
+	// test_group("group_semisort_int.csv", k, [](std::vector<int> &data, Comparator::Comparator comp) { return semisort(data); });
+	// test_group("group_radix_int.csv", k, radix_sort);
+	// test_group("group_hybrid_int.csv", k, hybrid_sort<int>);
+	// test_layout("lower_bound_int.csv", k, false);
+	// test_layout("eytzinger_int.csv", k, true);
 }
\ No newline at end of file
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <random>
+#include <algorithm>
+#include <type_traits>
+
+#include "sorting.h"
+
+#ifndef PROCESS_SORT
+#if defined(__unix__) || defined(__APPLE__)
+#define PROCESS_SORT 1
+#else
+#define PROCESS_SORT 0
+#endif
+#endif
+
+#ifndef PROCESS_WORKERS
+#define PROCESS_WORKERS 4
+#endif
+
+#if PROCESS_SORT
+#include <string>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
+
+#if PROCESS_SORT
+
+// Shared memory segment that stays mapped in forked children. The name is unlinked right away,
+// so the segment goes away with the last mapping.
+class SharedSegment
+{
+public:
+	explicit SharedSegment(size_t length) : length(length), data(nullptr)
+	{
+		// Concurrent sorts in one process need distinct names, O_EXCL would fail for the second one
+		static std::atomic<unsigned long> counter(0);
+		std::string name = "/aisd_sort_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+		int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+		if (fd < 0) return;
+
+		shm_unlink(name.c_str());
+
+		if (ftruncate(fd, length) == 0)
+		{
+			void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (p != MAP_FAILED) data = p;
+		}
+
+		close(fd);
+	}
+
+	~SharedSegment()
+	{
+		if (data) munmap(data, length);
+	}
+
+	SharedSegment(const SharedSegment &) = delete;
+	SharedSegment &operator=(const SharedSegment &) = delete;
+
+	void* get() const
+	{
+		return data;
+	}
+
+private:
+	size_t length;
+	void* data;
+};
+
+#endif
+
+// Moves [first, last) into out grouped by the partition of every element, partition p being the
+// elements after splitter p - 1 and up to splitter p. Fills in where each partition starts.
+template <class order, class it_t, class out_t>
+void range_partition(it_t first, size_t size, const std::vector<typename std::iterator_traits<it_t>::value_type> &splitters, out_t out, std::vector<size_t> &starts, Stats* stats)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	size_t parts = splitters.size() + 1;
+	std::vector<size_t> part(size);
+	std::vector<size_t> next(parts, 0);
+	long long compares = 0;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		part[i] = std::lower_bound(splitters.begin(), splitters.end(), first[i], [&compares](const t &a, const t &b)
+		{
+			compares++;
+			return order::before(a, b);
+		}) - splitters.begin();
+
+		next[part[i]]++;
+	}
+
+	starts.assign(parts + 1, 0);
+	for (size_t p = 0; p < parts; p++)
+	{
+		starts[p + 1] = starts[p] + next[p];
+		next[p] = starts[p];
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		out[next[part[i]]++] = first[i];
+	}
+
+	stats->compares += compares;
+	stats->swaps += size;
+}
+
+// Sorts with workers forked processes. The coordinator range-partitions the data into a shared memory
+// segment by sampled splitters, every worker sorts its partition there with the engine given by type
+// and the partitions are already in order once all of them are done. Falls back to sorting in this
+// process where fork and shared memory are not available.
+template <class it_t>
+Stats* process_sort(it_t first, it_t last, Comparator::Comparator comp, size_t workers = PROCESS_WORKERS, SortType::SortType type = SortType::HYBRID)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+	static_assert(std::is_trivially_copyable<t>::value, "process_sort needs records that can live in shared memory");
+	static_assert(std::is_trivially_copyable<Stats>::value, "the worker stats are written into shared memory without construction");
+
+	size_t size = last - first;
+	workers = std::max((size_t)1, std::min(workers, size / 2));
+
+#if PROCESS_SORT
+	if (workers > 1)
+	{
+		// Worker stats first, the records after them at a suitably aligned offset
+		size_t header = (workers * sizeof(Stats) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+		SharedSegment segment(header + size * sizeof(t));
+
+		if (segment.get())
+		{
+			Stats* worker_stats = (Stats*)segment.get();
+			t* shared = (t*)((char*)segment.get() + header);
+			Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+			std::minstd_rand random((unsigned int)size);
+			std::vector<t> sample(std::min(size, workers * 16));
+
+			for (auto it = sample.begin(); it != sample.end(); it++)
+			{
+				*it = first[random() % size];
+			}
+
+			Stats* sample_stats = hybrid_sort(sample.begin(), sample.end(), comp);
+			stats->compares += sample_stats->compares;
+			stats->swaps += sample_stats->swaps;
+			delete sample_stats;
+
+			std::vector<t> splitters(workers - 1);
+			for (size_t p = 0; p + 1 < workers; p++)
+			{
+				splitters[p] = sample[(p + 1) * sample.size() / workers];
+			}
+
+			std::vector<size_t> starts;
+			if (comp == Comparator::DECREASING)
+			{
+				range_partition<DecreasingOrder>(first, size, splitters, shared, starts, stats);
+			}
+			else
+			{
+				range_partition<IncreasingOrder>(first, size, splitters, shared, starts, stats);
+			}
+
+			std::vector<pid_t> children;
+			bool failed = false;
+
+			for (size_t p = 0; p < workers; p++)
+			{
+				pid_t pid = fork();
+
+				if (pid == 0)
+				{
+					Stats* part = sort_direct(shared + starts[p], shared + starts[p + 1], comp, type);
+
+					if (!part) _exit(1);
+
+					worker_stats[p] = *part;
+					_exit(0);
+				}
+
+				if (pid < 0)
+				{
+					// Sort what could not be handed out right here
+					Stats* part = sort_direct(shared + starts[p], shared + starts[p + 1], comp, type);
+
+					if (part) worker_stats[p] = *part;
+					else failed = true;
+
+					delete part;
+				}
+				else
+				{
+					children.push_back(pid);
+				}
+			}
+
+			for (auto it = children.begin(); it != children.end(); it++)
+			{
+				int status = 0;
+
+				if (waitpid(*it, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				{
+					failed = true;
+				}
+			}
+
+			if (failed)
+			{
+				delete stats;
+				return nullptr;
+			}
+
+			for (size_t p = 0; p < workers; p++)
+			{
+				stats->compares += worker_stats[p].compares;
+				stats->swaps += worker_stats[p].swaps;
+			}
+
+			std::copy(shared, shared + size, first);
+			stats->swaps += size;
+
+			return stats;
+		}
+	}
+#endif
+
+	return sort_direct(first, last, comp, type);
+}
+
+template <class t>
+Stats* process_sort(std::vector<t> &data, Comparator::Comparator comp, size_t workers = PROCESS_WORKERS, SortType::SortType type = SortType::HYBRID)
+{
+	return process_sort(data.begin(), data.end(), comp, workers, type);
+}
\ No newline at end of file
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "sorting.h"
+
+#ifndef TOP_K_HEAP_RATIO
+#define TOP_K_HEAP_RATIO 64
+#endif
+
+// Splits [range.lo, range.hi] into the elements before pivot, equal to it and after it.
+// The equal ones end up in [lt, gt).
+template <class it_t>
+void partition_three_way(it_t data, Comparator::Comparator comp, Stats* stats, Range range, const typename std::iterator_traits<it_t>::value_type &pivot, size_t &lt, size_t &gt)
+{
+	size_t i = range.lo;
+	lt = range.lo;
+	gt = range.hi + 1;
+
+	while (i < gt)
+	{
+		stats->compares++;
+
+		if (compare(comp, data[i], pivot, true))
+		{
+			stats->swaps++;
+
+			swap(data, lt++, i++);
+			continue;
+		}
+
+		stats->compares++;
+
+		if (compare(comp, pivot, data[i], true))
+		{
+			stats->swaps++;
+
+			swap(data, i, --gt);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+template <class it_t>
+void select_linear(it_t data, Comparator::Comparator comp, Stats* stats, Range range, size_t nth);
+
+// Median of the medians of groups of five, which leaves at least 3/10 of the range on either side
+template <class it_t>
+size_t median_of_medians(it_t data, Comparator::Comparator comp, Stats* stats, Range range)
+{
+	size_t size = range.hi - range.lo + 1;
+
+	if (size <= 5)
+	{
+		insertion_blocks(data + range.lo, size, size, comp, stats);
+		return range.lo + (size - 1) / 2;
+	}
+
+	// The median of every group is moved to the front of the range
+	size_t medians = range.lo;
+	for (size_t x = range.lo; x <= range.hi; x += 5)
+	{
+		size_t n = std::min((size_t)5, range.hi + 1 - x);
+		insertion_blocks(data + x, n, n, comp, stats);
+
+		stats->swaps++;
+
+		swap(data, medians++, x + (n - 1) / 2);
+	}
+
+	size_t middle = range.lo + (medians - range.lo - 1) / 2;
+	select_linear(data, comp, stats, { range.lo, medians - 1 }, middle);
+
+	return middle;
+}
+
+// Selection with a median of medians pivot, linear even when quickselect's pivots keep failing
+template <class it_t>
+void select_linear(it_t data, Comparator::Comparator comp, Stats* stats, Range range, size_t nth)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	while (range.lo < range.hi)
+	{
+		t pivot = data[median_of_medians(data, comp, stats, range)];
+
+		size_t lt, gt;
+		partition_three_way(data, comp, stats, range, pivot, lt, gt);
+
+		if (nth < lt) range.hi = lt - 1;
+		else if (nth >= gt) range.lo = gt;
+		else return;
+	}
+}
+
+// Allowed partitioning rounds before selection falls back to median of medians
+inline int select_depth(size_t size)
+{
+	int depth = 0;
+	while (size > 1)
+	{
+		size /= 2;
+		depth++;
+	}
+
+	return 2 * depth + 2;
+}
+
+template <class it_t>
+void quick_select_inner(it_t data, Comparator::Comparator comp, Stats* stats, Range range, size_t nth)
+{
+	int depth = select_depth(range.hi - range.lo + 1);
+
+	while (range.lo < range.hi)
+	{
+		if (depth-- == 0)
+		{
+			select_linear(data, comp, stats, range, nth);
+			return;
+		}
+
+		size_t middle = partition(data, comp, stats, range);
+
+		if (nth < middle) range.hi = middle - 1;
+		else if (nth > middle) range.lo = middle + 1;
+		else return;
+	}
+}
+
+// Puts the element that belongs at nth in sorted order there, with nothing after it on its left
+// and nothing before it on its right
+template <class it_t>
+Stats* quick_select(it_t first, it_t last, size_t nth, Comparator::Comparator comp)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	if (nth < size)
+	{
+		quick_select_inner(first, comp, stats, { 0, size - 1 }, nth);
+	}
+
+	return stats;
+}
+
+template <class t>
+Stats* quick_select(std::vector<t> &data, size_t nth, Comparator::Comparator comp)
+{
+	return quick_select(data.begin(), data.end(), nth, comp);
+}
+
+template <class it_t>
+void dual_pivot_select_inner(it_t data, Comparator::Comparator comp, Stats* stats, Range range, size_t nth)
+{
+	int depth = select_depth(range.hi - range.lo + 1);
+
+	while (range.lo < range.hi)
+	{
+		if (depth-- == 0)
+		{
+			select_linear(data, comp, stats, range, nth);
+			return;
+		}
+
+		size_t p, q;
+		if (!dual_pivot_partition(data, comp, stats, range, p, q))
+		{
+			return;
+		}
+
+		if (nth < p)
+		{
+			range.hi = p - 1;
+		}
+		else if (nth > q)
+		{
+			range.lo = q + 1;
+		}
+		else if (nth > p && nth < q)
+		{
+			range.lo = p + 1;
+			range.hi = q - 1;
+		}
+		else
+		{
+			return;
+		}
+	}
+}
+
+// Same contract as quick_select, the range is cut in three around two pivots each round
+template <class it_t>
+Stats* dual_pivot_select(it_t first, it_t last, size_t nth, Comparator::Comparator comp)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	if (nth < size)
+	{
+		dual_pivot_select_inner(first, comp, stats, { 0, size - 1 }, nth);
+	}
+
+	return stats;
+}
+
+template <class t>
+Stats* dual_pivot_select(std::vector<t> &data, size_t nth, Comparator::Comparator comp)
+{
+	return dual_pivot_select(data.begin(), data.end(), nth, comp);
+}
+
+// Sorts the first k elements of the sorted order into [first, first + k), the rest is left in any order
+template <class it_t>
+Stats* partial_quick_sort(it_t first, it_t last, size_t k, Comparator::Comparator comp)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	k = std::min(k, size);
+
+	if (k == 0)
+	{
+		return stats;
+	}
+
+	// Once the k-th element is in place only the ones before it still need sorting
+	size_t head_size = size;
+	if (k < size)
+	{
+		quick_select_inner(first, comp, stats, { 0, size - 1 }, k - 1);
+		head_size = k - 1;
+	}
+
+	Stats* head = hybrid_sort(first, first + head_size, comp);
+	add_stats(stats, *head);
+	delete head;
+
+	return stats;
+}
+
+template <class t>
+Stats* partial_quick_sort(std::vector<t> &data, size_t k, Comparator::Comparator comp)
+{
+	return partial_quick_sort(data.begin(), data.end(), k, comp);
+}
+
+// Sifts data[i] down a heap of size elements whose root is the one that comes last
+template <class it_t>
+void top_k_sift(it_t data, size_t size, size_t i, Comparator::Comparator comp, Stats* stats)
+{
+	size_t child;
+
+	while ((child = 2 * i + 1) < size)
+	{
+		if (child + 1 < size)
+		{
+			stats->compares++;
+
+			if (compare(comp, data[child], data[child + 1], true)) child++;
+		}
+
+		stats->compares++;
+
+		if (!compare(comp, data[i], data[child], true))
+		{
+			return;
+		}
+
+		stats->swaps++;
+
+		swap(data, i, child);
+		i = child;
+	}
+}
+
+// Same result as partial_quick_sort, but keeps the best k in a heap while scanning the rest once,
+// which costs about one compare per element when k is much smaller than the range
+template <class it_t>
+Stats* heap_top_k(it_t first, it_t last, size_t k, Comparator::Comparator comp)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	k = std::min(k, size);
+
+	if (k == 0)
+	{
+		return stats;
+	}
+
+	for (size_t i = k / 2; i-- > 0;)
+	{
+		top_k_sift(first, k, i, comp, stats);
+	}
+
+	for (size_t j = k; j < size; j++)
+	{
+		stats->compares++;
+
+		if (compare(comp, first[j], first[0], true))
+		{
+			stats->swaps++;
+
+			swap(first, 0, j);
+			top_k_sift(first, k, 0, comp, stats);
+		}
+	}
+
+	for (size_t end = k; end-- > 1;)
+	{
+		stats->swaps++;
+
+		swap(first, 0, end);
+		top_k_sift(first, end, 0, comp, stats);
+	}
+
+	return stats;
+}
+
+template <class t>
+Stats* heap_top_k(std::vector<t> &data, size_t k, Comparator::Comparator comp)
+{
+	return heap_top_k(data.begin(), data.end(), k, comp);
+}
+
+// Sorted top k of the range, the heap for k much smaller than the range and quickselect otherwise
+template <class it_t>
+Stats* top_k(it_t first, it_t last, size_t k, Comparator::Comparator comp)
+{
+	if (k * TOP_K_HEAP_RATIO <= (size_t)(last - first))
+	{
+		return heap_top_k(first, last, k, comp);
+	}
+
+	return partial_quick_sort(first, last, k, comp);
+}
+
+template <class t>
+Stats* top_k(std::vector<t> &data, size_t k, Comparator::Comparator comp)
+{
+	return top_k(data.begin(), data.end(), k, comp);
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+
+#include "sorting.h"
+
+#ifndef SEMISORT_BUCKET
+#define SEMISORT_BUCKET 1024
+#endif
+
+// Spreads the bits of a hash over the whole word, std::hash of an integer is often the integer itself
+inline uint64_t mix_hash(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb93fe53e87ebULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+// Groups the equal elements of [src + lo, src + hi) together at data + lo with a small open addressing
+// table, groups in the order their first element appears
+template <class t, class hash_t>
+void semisort_bucket(const std::vector<t> &src, std::vector<t> &data, size_t lo, size_t hi, hash_t hash, std::vector<uint32_t> &table, std::vector<uint32_t> &group_of, std::vector<size_t> &groups, Stats* stats)
+{
+	size_t size = hi - lo;
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	size_t slots = 2;
+	while (slots < 2 * size) slots *= 2;
+
+	table.assign(slots, 0);
+	group_of.resize(size);
+	groups.clear();
+
+	// groups holds the position of the first element of every group, followed later by its count
+	for (size_t i = 0; i < size; i++)
+	{
+		size_t slot = mix_hash(hash(src[lo + i])) & (slots - 1);
+
+		while (true)
+		{
+			if (table[slot] == 0)
+			{
+				groups.push_back(lo + i);
+				table[slot] = (uint32_t)groups.size();
+				break;
+			}
+
+			stats->compares++;
+
+			if (src[groups[table[slot] - 1]] == src[lo + i])
+			{
+				break;
+			}
+
+			slot = (slot + 1) & (slots - 1);
+		}
+
+		group_of[i] = table[slot] - 1;
+	}
+
+	std::vector<size_t> next(groups.size(), 0);
+	for (size_t i = 0; i < size; i++)
+	{
+		next[group_of[i]]++;
+	}
+
+	size_t sum = lo;
+	for (size_t g = 0; g < groups.size(); g++)
+	{
+		size_t count = next[g];
+		next[g] = sum;
+		sum += count;
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		data[next[group_of[i]]++] = src[lo + i];
+	}
+
+	stats->swaps += size;
+}
+
+// Brings equal elements next to each other without ordering the groups (semisort). Elements are
+// hashed into buckets of about SEMISORT_BUCKET elements in parallel, the same way sample_sort
+// distributes them, and every bucket is then grouped with a local hash table, O(n) expected
+// instead of O(n log n) compares. Only needs == and a hash for t.
+template <class t, class hash_t = std::hash<t>>
+Stats* semisort(std::vector<t> &data, hash_t hash = hash_t(), size_t threads = SAMPLE_THREADS)
+{
+	size_t size = data.size();
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	if (size < 2)
+	{
+		return stats;
+	}
+
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	int bits = 0;
+	while (bits < 20 && ((size_t)SEMISORT_BUCKET << bits) < size) bits++;
+
+	size_t buckets = (size_t)1 << bits;
+	threads = std::max((size_t)1, std::min(threads, size / SEMISORT_BUCKET));
+
+	// Top bits of the mixed hash pick the bucket, the local tables use the low ones
+	auto bucket_of = [&](const t &value) { return bits ? (size_t)(mix_hash(hash(value)) >> (64 - bits)) : 0; };
+
+	std::vector<uint32_t> oracle(size);
+	std::vector<size_t> counts(threads * buckets, 0);
+	size_t chunk = (size + threads - 1) / threads;
+
+	run_parallel(threads, [&](size_t id)
+	{
+		size_t lo = std::min(size, id * chunk), hi = std::min(size, lo + chunk);
+		size_t* count = &counts[id * buckets];
+
+		for (size_t i = lo; i < hi; i++)
+		{
+			oracle[i] = (uint32_t)bucket_of(data[i]);
+			count[oracle[i]]++;
+		}
+	});
+
+	std::vector<size_t> bucket_start(buckets + 1);
+	size_t sum = 0;
+
+	for (size_t b = 0; b < buckets; b++)
+	{
+		bucket_start[b] = sum;
+
+		for (size_t id = 0; id < threads; id++)
+		{
+			size_t count = counts[id * buckets + b];
+			counts[id * buckets + b] = sum;
+			sum += count;
+		}
+	}
+
+	bucket_start[buckets] = size;
+
+	std::vector<t> secondary(size);
+
+	run_parallel(threads, [&](size_t id)
+	{
+		size_t lo = std::min(size, id * chunk), hi = std::min(size, lo + chunk);
+		size_t* next = &counts[id * buckets];
+
+		for (size_t i = lo; i < hi; i++)
+		{
+			secondary[next[oracle[i]]++] = std::move(data[i]);
+		}
+	});
+
+	stats->swaps += size;
+
+	std::atomic<size_t> next_bucket(0);
+	std::vector<Stats> bucket_stats(threads, Stats{ 0, 0, 0, 0.0 });
+
+	run_parallel(threads, [&](size_t id)
+	{
+		std::vector<uint32_t> table, group_of;
+		std::vector<size_t> groups;
+
+		for (size_t b = next_bucket++; b < buckets; b = next_bucket++)
+		{
+			semisort_bucket(secondary, data, bucket_start[b], bucket_start[b + 1], hash, table, group_of, groups, &bucket_stats[id]);
+		}
+	});
+
+	for (auto it = bucket_stats.begin(); it != bucket_stats.end(); it++)
+	{
+		add_stats(stats, *it);
+	}
+
+	return stats;
+}
\ No newline at end of file
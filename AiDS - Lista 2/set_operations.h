@@ -0,0 +1,464 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "sorting.h"
+
+// Size ratio from which the smaller range is walked and the larger one galloped over
+#ifndef SET_GALLOP_RATIO
+#define SET_GALLOP_RATIO 16
+#endif
+
+// All operations take ranges sorted by comp and follow the multiset rules of the std:: algorithms,
+// an element present m times in a and n times in b is kept min(m, n) times by the intersection,
+// max(m, n) times by the union and max(m - n, 0) times by the difference. On ties the element of a is
+// the one written.
+
+// First position from pos that does not go before value (or, with upper, that goes after it),
+// found by doubling the step and then binary searching the last step
+template <class order, class t>
+size_t gallop(const t* data, size_t pos, size_t size, const t &value, bool upper, Stats* stats)
+{
+	auto past = [&](size_t i)
+	{
+		stats->compares++;
+		return upper ? order::before(value, data[i]) : !order::before(data[i], value);
+	};
+
+	size_t lo = pos, step = 1;
+
+	while (lo < size && !past(lo))
+	{
+		pos = lo + 1;
+		lo += step;
+		step *= 2;
+	}
+
+	size_t hi = std::min(lo, size);
+
+	// Everything before pos goes before value, data[hi] (if any) is past it
+	while (pos < hi)
+	{
+		size_t mid = pos + (hi - pos) / 2;
+
+		if (past(mid))
+		{
+			hi = mid;
+		}
+		else
+		{
+			pos = mid + 1;
+		}
+	}
+
+	return pos;
+}
+
+inline bool skewed(size_t na, size_t nb)
+{
+	return na / SET_GALLOP_RATIO > nb || nb / SET_GALLOP_RATIO > na;
+}
+
+// Linear intersection, stops once either range is exhausted
+template <class order, class t>
+void intersection_steps(const t* a, size_t &i, size_t a_end, const t* b, size_t &j, size_t b_end, std::vector<t> &out, Stats* stats)
+{
+	// Counted locally, out may alias stats as far as the compiler knows
+	long long compares = 0;
+
+	while (i < a_end && j < b_end)
+	{
+		compares++;
+
+		if (order::before(a[i], b[j]))
+		{
+			i++;
+			continue;
+		}
+
+		compares++;
+
+		if (order::before(b[j], a[i]))
+		{
+			j++;
+		}
+		else
+		{
+			out.push_back(a[i]);
+			i++;
+			j++;
+		}
+	}
+
+	stats->compares += compares;
+}
+
+#if SIMD_MERGE
+
+// Compares 8 elements of a with 8 of b all against all. Blocks without a common element are skipped
+// whole, the block with the smaller last element holds nothing that can still match, and blocks that
+// share something are handed to the scalar loop so duplicates keep the multiset rules.
+AVX2_TARGET inline void simd_intersection(const int* a, size_t &i, size_t na, const int* b, size_t &j, size_t nb, std::vector<int> &out, Stats* stats)
+{
+	const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+
+	while (i + 8 <= na && j + 8 <= nb)
+	{
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+		__m256i match = _mm256_cmpeq_epi32(va, vb);
+
+		for (int r = 1; r < 8; r++)
+		{
+			vb = _mm256_permutevar8x32_epi32(vb, rotate);
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi32(va, vb));
+		}
+
+		// One block compare and the compare of the last elements
+		stats->compares += 2;
+
+		if (_mm256_testz_si256(match, match))
+		{
+			int a_last = a[i + 7], b_last = b[j + 7];
+
+			if (a_last <= b_last) i += 8;
+			if (b_last <= a_last) j += 8;
+		}
+		else
+		{
+			intersection_steps<IncreasingOrder, int>(a, i, std::min(na, i + 8), b, j, std::min(nb, j + 8), out, stats);
+		}
+	}
+}
+
+#endif
+
+template <class order, class t>
+void intersection_inner(const t* a, size_t na, const t* b, size_t nb, std::vector<t> &out, Stats* stats, std::false_type)
+{
+	size_t i = 0, j = 0;
+	intersection_steps<order, t>(a, i, na, b, j, nb, out, stats);
+}
+
+template <class order, class t>
+void intersection_inner(const t* a, size_t na, const t* b, size_t nb, std::vector<t> &out, Stats* stats, std::true_type)
+{
+	size_t i = 0, j = 0;
+
+#if SIMD_MERGE
+	if (std::is_same<order, IncreasingOrder>::value && std::is_same<t, int>::value && simd_merge_enabled())
+	{
+		simd_intersection(a, i, na, b, j, nb, out, stats);
+	}
+#endif
+
+	intersection_steps<order, t>(a, i, na, b, j, nb, out, stats);
+}
+
+template <class order, class t>
+void sorted_intersection_inner(const t* a, size_t na, const t* b, size_t nb, std::vector<t> &out, Stats* stats)
+{
+	if (!skewed(na, nb))
+	{
+		intersection_inner<order, t>(a, na, b, nb, out, stats, std::is_same<t, int>());
+		return;
+	}
+
+	bool a_small = na < nb;
+	const t* small = a_small ? a : b;
+	const t* large = a_small ? b : a;
+	size_t n_small = a_small ? na : nb, n_large = a_small ? nb : na;
+	size_t pos = 0;
+
+	for (size_t i = 0; i < n_small && pos < n_large; i++)
+	{
+		pos = gallop<order>(large, pos, n_large, small[i], false, stats);
+
+		if (pos == n_large)
+		{
+			break;
+		}
+
+		stats->compares++;
+
+		if (!order::before(small[i], large[pos]))
+		{
+			out.push_back(a_small ? small[i] : large[pos]);
+			pos++;
+		}
+	}
+}
+
+template <class order, class t>
+void sorted_union_inner(const t* a, size_t na, const t* b, size_t nb, std::vector<t> &out, Stats* stats)
+{
+	if (!skewed(na, nb))
+	{
+		size_t i = 0, j = 0;
+		long long compares = 0;
+
+		while (i < na && j < nb)
+		{
+			compares++;
+
+			if (order::before(a[i], b[j]))
+			{
+				out.push_back(a[i++]);
+				continue;
+			}
+
+			compares++;
+
+			if (order::before(b[j], a[i]))
+			{
+				out.push_back(b[j++]);
+			}
+			else
+			{
+				out.push_back(a[i++]);
+				j++;
+			}
+		}
+
+		stats->compares += compares;
+
+		out.insert(out.end(), a + i, a + na);
+		out.insert(out.end(), b + j, b + nb);
+		return;
+	}
+
+	// Runs of the larger range between two elements of the smaller one are copied whole
+	bool a_small = na < nb;
+	const t* small = a_small ? a : b;
+	const t* large = a_small ? b : a;
+	size_t n_small = a_small ? na : nb, n_large = a_small ? nb : na;
+	size_t pos = 0;
+
+	for (size_t i = 0; i < n_small; i++)
+	{
+		size_t next = gallop<order>(large, pos, n_large, small[i], false, stats);
+		out.insert(out.end(), large + pos, large + next);
+		pos = next;
+
+		if (pos < n_large)
+		{
+			stats->compares++;
+
+			if (!order::before(small[i], large[pos]))
+			{
+				out.push_back(a_small ? small[i] : large[pos]);
+				pos++;
+				continue;
+			}
+		}
+
+		out.push_back(small[i]);
+	}
+
+	out.insert(out.end(), large + pos, large + n_large);
+}
+
+template <class order, class t>
+void sorted_difference_inner(const t* a, size_t na, const t* b, size_t nb, std::vector<t> &out, Stats* stats)
+{
+	size_t i = 0, j = 0;
+
+	if (!skewed(na, nb))
+	{
+		long long compares = 0;
+
+		while (i < na && j < nb)
+		{
+			compares++;
+
+			if (order::before(a[i], b[j]))
+			{
+				out.push_back(a[i++]);
+				continue;
+			}
+
+			compares++;
+
+			if (order::before(b[j], a[i]))
+			{
+				j++;
+			}
+			else
+			{
+				i++;
+				j++;
+			}
+		}
+
+		stats->compares += compares;
+	}
+	else if (na < nb)
+	{
+		// Every element of a is looked up in b
+		for (; i < na && j < nb; i++)
+		{
+			j = gallop<order>(b, j, nb, a[i], false, stats);
+
+			if (j < nb)
+			{
+				stats->compares++;
+
+				if (!order::before(a[i], b[j]))
+				{
+					j++;
+					continue;
+				}
+			}
+
+			out.push_back(a[i]);
+		}
+	}
+	else
+	{
+		// Runs of a between the elements of b are copied whole
+		for (; j < nb && i < na; j++)
+		{
+			size_t next = gallop<order>(a, i, na, b[j], false, stats);
+			out.insert(out.end(), a + i, a + next);
+			i = next;
+
+			if (i < na)
+			{
+				stats->compares++;
+
+				if (!order::before(b[j], a[i]))
+				{
+					i++;
+				}
+			}
+		}
+	}
+
+	out.insert(out.end(), a + i, a + na);
+}
+
+template <class order, class t>
+void sorted_merge_inner(const t* a, size_t na, const t* b, size_t nb, std::vector<t> &out, Comparator::Comparator comp, Stats* stats)
+{
+	size_t start = out.size();
+	out.resize(start + na + nb);
+	t* dst = out.data() + start;
+
+	if (na == 0 || nb == 0)
+	{
+		std::copy(a, a + na, std::copy(b, b + nb, dst));
+		return;
+	}
+
+	// Every element is moved once on both paths
+	if (!skewed(na, nb))
+	{
+		count_merge(a, na, b, nb, comp, stats, true);
+
+		merge_sorted_runs(a, na, b, nb, dst, comp == Comparator::DECREASING, simd_mergeable<t>());
+		return;
+	}
+
+	stats->swaps += na + nb;
+
+	// Elements of a go before equal elements of b, so a stops at the first element after b[j] and b
+	// stops at the first element not before a[i]
+	size_t i = 0, j = 0;
+
+	if (na < nb)
+	{
+		for (; i < na; i++)
+		{
+			size_t next = gallop<order>(b, j, nb, a[i], false, stats);
+			dst = std::copy(b + j, b + next, dst);
+			j = next;
+			*dst++ = a[i];
+		}
+	}
+	else
+	{
+		for (; j < nb; j++)
+		{
+			size_t next = gallop<order>(a, i, na, b[j], true, stats);
+			dst = std::copy(a + i, a + next, dst);
+			i = next;
+			*dst++ = b[j];
+		}
+	}
+
+	dst = std::copy(a + i, a + na, dst);
+	std::copy(b + j, b + nb, dst);
+}
+
+// Appends the merge of a and b (both sorted by comp) to out, a comes first on ties
+template <class t>
+Stats* sorted_merge(const std::vector<t> &a, const std::vector<t> &b, std::vector<t> &out, Comparator::Comparator comp)
+{
+	Stats* stats = new Stats{ a.size() + b.size(), 0, 0, 0.0 };
+
+	if (comp == Comparator::DECREASING)
+	{
+		sorted_merge_inner<DecreasingOrder>(a.data(), a.size(), b.data(), b.size(), out, comp, stats);
+	}
+	else
+	{
+		sorted_merge_inner<IncreasingOrder>(a.data(), a.size(), b.data(), b.size(), out, comp, stats);
+	}
+
+	return stats;
+}
+
+// Appends the elements found in both a and b to out
+template <class t>
+Stats* sorted_intersection(const std::vector<t> &a, const std::vector<t> &b, std::vector<t> &out, Comparator::Comparator comp)
+{
+	Stats* stats = new Stats{ a.size() + b.size(), 0, 0, 0.0 };
+
+	if (comp == Comparator::DECREASING)
+	{
+		sorted_intersection_inner<DecreasingOrder>(a.data(), a.size(), b.data(), b.size(), out, stats);
+	}
+	else
+	{
+		sorted_intersection_inner<IncreasingOrder>(a.data(), a.size(), b.data(), b.size(), out, stats);
+	}
+
+	return stats;
+}
+
+// Appends the elements found in a or b to out
+template <class t>
+Stats* sorted_union(const std::vector<t> &a, const std::vector<t> &b, std::vector<t> &out, Comparator::Comparator comp)
+{
+	Stats* stats = new Stats{ a.size() + b.size(), 0, 0, 0.0 };
+
+	if (comp == Comparator::DECREASING)
+	{
+		sorted_union_inner<DecreasingOrder>(a.data(), a.size(), b.data(), b.size(), out, stats);
+	}
+	else
+	{
+		sorted_union_inner<IncreasingOrder>(a.data(), a.size(), b.data(), b.size(), out, stats);
+	}
+
+	return stats;
+}
+
+// Appends the elements of a not found in b to out
+template <class t>
+Stats* sorted_difference(const std::vector<t> &a, const std::vector<t> &b, std::vector<t> &out, Comparator::Comparator comp)
+{
+	Stats* stats = new Stats{ a.size() + b.size(), 0, 0, 0.0 };
+
+	if (comp == Comparator::DECREASING)
+	{
+		sorted_difference_inner<DecreasingOrder>(a.data(), a.size(), b.data(), b.size(), out, stats);
+	}
+	else
+	{
+		sorted_difference_inner<IncreasingOrder>(a.data(), a.size(), b.data(), b.size(), out, stats);
+	}
+
+	return stats;
+}
\ No newline at end of file
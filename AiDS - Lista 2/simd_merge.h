@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#ifndef SIMD_MERGE
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_MERGE 1
+#else
+#define SIMD_MERGE 0
+#endif
+#endif
+
+#if SIMD_MERGE
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// Types the vectorized merge handles, everything else uses the scalar loop
+template <class t>
+struct simd_mergeable : std::integral_constant<bool, SIMD_MERGE && (std::is_same<t, int>::value || std::is_same<t, float>::value)> {};
+
+template <class t, bool desc>
+inline bool merge_before(const t &x, const t &y)
+{
+	return desc ? (x > y) : (x < y);
+}
+
+// Scalar merge of up to three sorted sequences, used for inputs too short for a vector block
+template <class t, bool desc>
+t* merge_scalar(const t* a, const t* a_end, const t* b, const t* b_end, const t* c, const t* c_end, t* out)
+{
+	while (a != a_end && b != b_end && c != c_end)
+	{
+		if (merge_before<t, desc>(*b, *a))
+		{
+			*out++ = merge_before<t, desc>(*c, *b) ? *c++ : *b++;
+		}
+		else
+		{
+			*out++ = merge_before<t, desc>(*c, *a) ? *c++ : *a++;
+		}
+	}
+
+	if (a == a_end)
+	{
+		a = c;
+		a_end = c_end;
+	}
+	else if (b == b_end)
+	{
+		b = c;
+		b_end = c_end;
+	}
+
+	while (a != a_end && b != b_end)
+	{
+		*out++ = merge_before<t, desc>(*b, *a) ? *b++ : *a++;
+	}
+
+	out = std::copy(a, a_end, out);
+	return std::copy(b, b_end, out);
+}
+
+#if SIMD_MERGE
+
+inline bool cpu_has_avx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+
+	// AVX registers have to be enabled by the OS as well
+	bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+
+	__cpuidex(info, 7, 0);
+	return os_avx && (info[1] & (1 << 5));
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+inline bool simd_merge_enabled()
+{
+	static const bool enabled = cpu_has_avx2();
+	return enabled;
+}
+
+struct Avx2Int
+{
+	typedef int value_type;
+	typedef __m256i reg;
+
+	static AVX2_TARGET inline reg load(const int* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static AVX2_TARGET inline void store(int* p, reg x) { _mm256_storeu_si256((__m256i*)p, x); }
+	static AVX2_TARGET inline reg min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+	static AVX2_TARGET inline reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+	static AVX2_TARGET inline reg reverse(reg x) { return _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+	static AVX2_TARGET inline reg swap_halves(reg x) { return _mm256_permute2x128_si256(x, x, 1); }
+	static AVX2_TARGET inline reg swap_pairs(reg x) { return _mm256_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)); }
+	static AVX2_TARGET inline reg swap_adjacent(reg x) { return _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+	template <int mask>
+	static AVX2_TARGET inline reg blend(reg a, reg b) { return _mm256_blend_epi32(a, b, mask); }
+};
+
+struct Avx2Float
+{
+	typedef float value_type;
+	typedef __m256 reg;
+
+	static AVX2_TARGET inline reg load(const float* p) { return _mm256_loadu_ps(p); }
+	static AVX2_TARGET inline void store(float* p, reg x) { _mm256_storeu_ps(p, x); }
+	static AVX2_TARGET inline reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+	static AVX2_TARGET inline reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+	static AVX2_TARGET inline reg reverse(reg x) { return _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+	static AVX2_TARGET inline reg swap_halves(reg x) { return _mm256_permute2f128_ps(x, x, 1); }
+	static AVX2_TARGET inline reg swap_pairs(reg x) { return _mm256_shuffle_ps(x, x, _MM_SHUFFLE(1, 0, 3, 2)); }
+	static AVX2_TARGET inline reg swap_adjacent(reg x) { return _mm256_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+	template <int mask>
+	static AVX2_TARGET inline reg blend(reg a, reg b) { return _mm256_blend_ps(a, b, mask); }
+};
+
+template <class t>
+struct Avx2Ops;
+
+template <>
+struct Avx2Ops<int> : Avx2Int {};
+
+template <>
+struct Avx2Ops<float> : Avx2Float {};
+
+// One half-cleaner stage: lanes selected by mask keep the later element of each pair
+template <class ops, bool desc, int mask>
+AVX2_TARGET inline typename ops::reg bitonic_stage(typename ops::reg x, typename ops::reg p)
+{
+	if (desc)
+	{
+		return ops::template blend<mask>(ops::max(x, p), ops::min(x, p));
+	}
+
+	return ops::template blend<mask>(ops::min(x, p), ops::max(x, p));
+}
+
+// Merges two sorted registers, a receives the first 8 elements and b the last 8
+template <class ops, bool desc>
+AVX2_TARGET inline void bitonic_merge_8(typename ops::reg &a, typename ops::reg &b)
+{
+	typedef typename ops::reg reg;
+
+	b = ops::reverse(b);
+
+	reg lo = desc ? ops::max(a, b) : ops::min(a, b);
+	reg hi = desc ? ops::min(a, b) : ops::max(a, b);
+
+	lo = bitonic_stage<ops, desc, 0xF0>(lo, ops::swap_halves(lo));
+	hi = bitonic_stage<ops, desc, 0xF0>(hi, ops::swap_halves(hi));
+	lo = bitonic_stage<ops, desc, 0xCC>(lo, ops::swap_pairs(lo));
+	hi = bitonic_stage<ops, desc, 0xCC>(hi, ops::swap_pairs(hi));
+	lo = bitonic_stage<ops, desc, 0xAA>(lo, ops::swap_adjacent(lo));
+	hi = bitonic_stage<ops, desc, 0xAA>(hi, ops::swap_adjacent(hi));
+
+	a = lo;
+	b = hi;
+}
+
+// Merges a and b into out 8 elements at a time, the next block always comes from the run with the smaller head
+template <class t, bool desc>
+AVX2_TARGET void simd_merge_avx2(const t* a, size_t na, const t* b, size_t nb, t* out)
+{
+	typedef Avx2Ops<t> ops;
+	typedef typename ops::reg reg;
+
+	reg va = ops::load(a);
+	reg vb = ops::load(b);
+	size_t ia = 8, ib = 8;
+
+	while (true)
+	{
+		bitonic_merge_8<ops, desc>(va, vb);
+		ops::store(out, va);
+		out += 8;
+
+		if (ia < na && (ib == nb || !merge_before<t, desc>(b[ib], a[ia])))
+		{
+			if (ia + 8 > na) break;
+
+			va = ops::load(a + ia);
+			ia += 8;
+		}
+		else if (ib < nb)
+		{
+			if (ib + 8 > nb) break;
+
+			va = ops::load(b + ib);
+			ib += 8;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	t rest[8];
+	ops::store(rest, vb);
+
+	merge_scalar<t, desc>(rest, rest + 8, a + ia, a + na, b + ib, b + nb, out);
+}
+
+#else
+
+inline bool simd_merge_enabled()
+{
+	return false;
+}
+
+#endif
+
+// Merges the sorted runs a and b into out, vectorized when the CPU allows it
+template <class t>
+void simd_merge(const t* a, size_t na, const t* b, size_t nb, t* out, bool desc)
+{
+#if SIMD_MERGE
+	if (na >= 8 && nb >= 8 && simd_merge_enabled())
+	{
+		if (desc)
+		{
+			simd_merge_avx2<t, true>(a, na, b, nb, out);
+		}
+		else
+		{
+			simd_merge_avx2<t, false>(a, na, b, nb, out);
+		}
+
+		return;
+	}
+#endif
+
+	if (desc)
+	{
+		merge_scalar<t, true>(a, a + na, b, b + nb, b + nb, b + nb, out);
+	}
+	else
+	{
+		merge_scalar<t, false>(a, a + na, b, b + nb, b + nb, b + nb, out);
+	}
+}
\ No newline at end of file
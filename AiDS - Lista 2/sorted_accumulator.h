@@ -0,0 +1,331 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+
+#include "sorting.h"
+
+#ifndef ACCUMULATOR_BUFFER
+#define ACCUMULATOR_BUFFER 4096
+#endif
+
+// Merges two separately stored sorted runs into a new one
+template <class t>
+std::shared_ptr<const std::vector<t>> merge_sorted_runs(const std::vector<t> &a, const std::vector<t> &b, Comparator::Comparator comp, Stats* stats)
+{
+	std::shared_ptr<std::vector<t>> out = std::make_shared<std::vector<t>>(a.size() + b.size());
+
+	if (!a.empty() && !b.empty())
+	{
+		count_merge(a.data(), a.size(), b.data(), b.size(), comp, stats, true);
+	}
+
+	merge_sorted_runs(a.data(), a.size(), b.data(), b.size(), out->data(), comp == Comparator::DECREASING, simd_mergeable<t>());
+
+	return out;
+}
+
+// Sorted container for data that keeps arriving (log-structured merging). Producers fill private
+// buffers, a full buffer is sorted into a run and level i holds runs of about buffer_size * 2^i elements.
+// Whenever a level has two runs they are merged into one on the next level, in a background thread
+// if asked for, so every element is merged O(log n) times in total instead of being re-sorted with
+// everything else on every batch. Runs are never modified once published, so readers copy the list
+// of runs under the lock and do their merging outside of it.
+template <class t>
+class SortedAccumulator
+{
+public:
+	typedef std::shared_ptr<const std::vector<t>> run_ptr;
+
+	// Per-thread handle, add() takes no lock until the buffer is full
+	class Producer
+	{
+	public:
+		explicit Producer(SortedAccumulator* owner) : owner(owner)
+		{
+			buffer.reserve(owner->buffer_size);
+		}
+
+		Producer(Producer &&other) : owner(other.owner), buffer(std::move(other.buffer))
+		{
+			other.owner = nullptr;
+		}
+
+		~Producer()
+		{
+			if (owner) flush();
+		}
+
+		void add(const t &value)
+		{
+			buffer.push_back(value);
+
+			if (buffer.size() >= owner->buffer_size)
+			{
+				flush();
+			}
+		}
+
+		// Publishes whatever is buffered, elements are visible to readers only after this
+		void flush()
+		{
+			if (buffer.empty()) return;
+
+			Stats* stats = hybrid_sort(buffer, owner->comp);
+			owner->publish(std::make_shared<const std::vector<t>>(std::move(buffer)), *stats);
+			delete stats;
+
+			buffer.clear();
+			buffer.reserve(owner->buffer_size);
+		}
+
+	private:
+		SortedAccumulator* owner;
+		std::vector<t> buffer;
+	};
+
+	// Walks a snapshot of the runs in sorted order, picking the smallest head of the few runs each step
+	class Reader
+	{
+	public:
+		Reader(std::vector<run_ptr> runs, Comparator::Comparator comp) : runs(std::move(runs)), comp(comp), pos(this->runs.size(), 0) {}
+
+		bool done() const
+		{
+			for (size_t r = 0; r < runs.size(); r++)
+			{
+				if (pos[r] < runs[r]->size()) return false;
+			}
+
+			return true;
+		}
+
+		// Next element in sorted order, must not be called once done()
+		const t& next()
+		{
+			size_t best = runs.size();
+
+			for (size_t r = 0; r < runs.size(); r++)
+			{
+				if (pos[r] == runs[r]->size()) continue;
+
+				if (best == runs.size() || compare(comp, (*runs[r])[pos[r]], (*runs[best])[pos[best]], true))
+				{
+					best = r;
+				}
+			}
+
+			return (*runs[best])[pos[best]++];
+		}
+
+	private:
+		std::vector<run_ptr> runs;
+		Comparator::Comparator comp;
+		std::vector<size_t> pos;
+	};
+
+	explicit SortedAccumulator(Comparator::Comparator comp, size_t buffer_size = ACCUMULATOR_BUFFER, bool background = true)
+		: comp(comp), buffer_size(std::max((size_t)1, buffer_size)), counters{ 0, 0, 0, 0.0 }, merging(false), stopping(false)
+	{
+		if (background)
+		{
+			merger = std::thread(&SortedAccumulator::merge_loop, this);
+		}
+	}
+
+	~SortedAccumulator()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		changed.notify_all();
+
+		if (merger.joinable()) merger.join();
+	}
+
+	SortedAccumulator(const SortedAccumulator &) = delete;
+	SortedAccumulator &operator=(const SortedAccumulator &) = delete;
+
+	Producer producer()
+	{
+		return Producer(this);
+	}
+
+	// Every published element, sorted
+	std::vector<t> snapshot()
+	{
+		std::vector<run_ptr> list = runs();
+		Stats stats = { 0, 0, 0, 0.0 };
+
+		// Smallest runs first, so the large ones are copied as few times as possible
+		std::sort(list.begin(), list.end(), [](const run_ptr &a, const run_ptr &b) { return a->size() < b->size(); });
+
+		run_ptr result = std::make_shared<const std::vector<t>>();
+		for (auto it = list.begin(); it != list.end(); it++)
+		{
+			result = merge_sorted_runs(*result, **it, comp, &stats);
+		}
+
+		add_counters(stats);
+
+		return *result;
+	}
+
+	Reader reader()
+	{
+		return Reader(runs(), comp);
+	}
+
+	// Blocks until no level holds more than one run
+	void wait_merged()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if (!merger.joinable())
+		{
+			lock.unlock();
+			while (merge_step()) {}
+			return;
+		}
+
+		idle.wait(lock, [this]() { return !merging && !pending(); });
+	}
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		return counters.size;
+	}
+
+	Stats stats()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		return counters;
+	}
+
+private:
+	Comparator::Comparator comp;
+	size_t buffer_size;
+	Stats counters;
+
+	std::mutex mutex;
+	std::condition_variable changed, idle;
+	std::vector<std::vector<run_ptr>> levels;
+	bool merging, stopping;
+	std::thread merger;
+
+	void publish(run_ptr run, const Stats &sort_stats)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (levels.empty()) levels.resize(1);
+			levels[0].push_back(run);
+
+			counters.size += run->size();
+			add_stats(&counters, sort_stats);
+		}
+
+		if (merger.joinable())
+		{
+			changed.notify_one();
+		}
+		else
+		{
+			while (merge_step()) {}
+		}
+	}
+
+	std::vector<run_ptr> runs()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<run_ptr> list;
+
+		for (auto level = levels.begin(); level != levels.end(); level++)
+		{
+			list.insert(list.end(), level->begin(), level->end());
+		}
+
+		return list;
+	}
+
+	void add_counters(const Stats &stats)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		add_stats(&counters, stats);
+	}
+
+	// Lowest level with two runs to merge, levels.size() if there is none. Needs the lock.
+	size_t pending_level()
+	{
+		for (size_t l = 0; l < levels.size(); l++)
+		{
+			if (levels[l].size() >= 2) return l;
+		}
+
+		return levels.size();
+	}
+
+	bool pending()
+	{
+		return pending_level() < levels.size();
+	}
+
+	// Merges the two oldest runs of the lowest full level. The inputs stay listed until the result
+	// replaces them, so a snapshot taken meanwhile still sees every element exactly once.
+	bool merge_step()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		// One merge at a time, whoever is merging picks up the new work once done
+		size_t level = pending_level();
+		if (merging || level == levels.size()) return false;
+
+		run_ptr a = levels[level][0];
+		run_ptr b = levels[level][1];
+		merging = true;
+		lock.unlock();
+
+		Stats stats = { 0, 0, 0, 0.0 };
+		run_ptr merged = merge_sorted_runs(*a, *b, comp, &stats);
+
+		lock.lock();
+		std::vector<run_ptr> &runs = levels[level];
+		runs.erase(std::remove_if(runs.begin(), runs.end(), [&](const run_ptr &r) { return r == a || r == b; }), runs.end());
+
+		if (levels.size() <= level + 1) levels.resize(level + 2);
+		levels[level + 1].push_back(merged);
+
+		add_stats(&counters, stats);
+		merging = false;
+
+		return true;
+	}
+
+	void merge_loop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true)
+		{
+			changed.wait(lock, [this]() { return stopping || pending(); });
+
+			if (stopping) return;
+
+			lock.unlock();
+			while (merge_step()) {}
+			lock.lock();
+
+			if (!pending()) idle.notify_all();
+		}
+	}
+};
\ No newline at end of file
@@ -4,14 +4,68 @@
 #include <iostream>
 #include <algorithm>
 #include <stack>
+#include <iterator>
+#include <type_traits>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <cstdint>
+
+#include "simd_merge.h"
+#include "cache_info.h"
 
 #define PRINT_INFO 0
 
+#ifndef MULTIWAY_WAYS
+#define MULTIWAY_WAYS 16
+#endif
+
+#ifndef COUNTING_RANGE_RATIO
+#define COUNTING_RANGE_RATIO 1
+#endif
+
+#ifndef SAMPLE_BUCKETS
+#define SAMPLE_BUCKETS 256
+#endif
+
+#ifndef SAMPLE_MIN_SIZE
+#define SAMPLE_MIN_SIZE 4096
+#endif
+
+#ifndef SAMPLE_THREADS
+#define SAMPLE_THREADS 0
+#endif
+
+#ifndef MERGE_INSERT_MAX
+#define MERGE_INSERT_MAX 32
+#endif
+
+#ifndef BINARY_INSERT_MAX
+#define BINARY_INSERT_MAX 1024
+#endif
+
+#ifndef EXPENSIVE_COMPARE_NS
+#define EXPENSIVE_COMPARE_NS 50
+#endif
+
+#ifndef HEAP_ARITY
+#define HEAP_ARITY 4
+#endif
+
+#ifndef FLAG_CUT_OFF
+#define FLAG_CUT_OFF 64
+#endif
+
+#ifndef INDIRECT_MIN_SIZE
+#define INDIRECT_MIN_SIZE 64
+#endif
+
 namespace SortType
 {
 	enum SortType
 	{
-		NONE, INSERT, MERGE, QUICK, HYBRID, DUAL, RADIX
+		NONE, INSERT, MERGE, QUICK, HYBRID, DUAL, RADIX, PREFIX, LCP, DICT, MULTIWAY, FLAG, SAMPLE, PROCESS, BINARY, MERGE_INSERT, AUTO, HEAP, INTRO, BLOCK
 	};
 }
 
@@ -25,9 +79,11 @@ namespace Comparator
 
 struct Stats
 {
-	size_t size;
-	long long compares, swaps;
-	double time;
+	size_t size = 0;
+	long long compares = 0, swaps = 0;
+	double time = 0.0;
+	long long characters = 0;
+	long long encode_compares = 0;
 };
 
 struct Range
@@ -41,8 +97,14 @@ void swap(std::vector<t> &data, size_t i, size_t j)
 	std::swap(data[i], data[j]);
 }
 
+template <class it_t>
+void swap(it_t data, size_t i, size_t j)
+{
+	std::iter_swap(data + i, data + j);
+}
+
 template <class t>
-bool compare(Comparator::Comparator comp, t i, t j, bool strict)
+bool compare(Comparator::Comparator comp, const t &i, const t &j, bool strict)
 {
 	switch (comp)
 	{
@@ -55,11 +117,12 @@ bool compare(Comparator::Comparator comp, t i, t j, bool strict)
 	}
 }
 
-template <class t>
-bool vector_sorted(std::vector<t> &data, Comparator::Comparator comp) {
-	for (size_t i = 1; i < data.size(); i++)
+template <class it_t>
+bool range_sorted(it_t first, it_t last, Comparator::Comparator comp)
+{
+	for (it_t it = first; it != last && it + 1 != last; it++)
 	{
-		if (!compare(comp, data[i - 1], data[i], false))
+		if (!compare(comp, *it, *(it + 1), false))
 		{
 			return false;
 		}
@@ -69,12 +132,18 @@ bool vector_sorted(std::vector<t> &data, Comparator::Comparator comp) {
 }
 
 template <class t>
-Stats* insertion_sort(std::vector<t> &data, Comparator::Comparator comp)
+bool vector_sorted(std::vector<t> &data, Comparator::Comparator comp) {
+	return range_sorted(data.begin(), data.end(), comp);
+}
+
+template <class it_t>
+Stats* insertion_sort(it_t first, it_t last, Comparator::Comparator comp)
 {
-	Stats* stats = new Stats{ data.size(), 0, 0, 0.0 };
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
 	size_t i, j;
 
-	for (i = 1; i < data.size(); i++)
+	for (i = 1; i < size; i++)
 	{
 		j = i;
 
@@ -84,19 +153,19 @@ Stats* insertion_sort(std::vector<t> &data, Comparator::Comparator comp)
 
 			if (PRINT_INFO)
 			{
-				std::cerr << "Compare:\n\tdata[" << (j - 1) << "] (= " << data[j - 1] << ")\n\twith\n\tdata[" << j << "] (= " << data[j] << ")" << std::endl;
+				std::cerr << "Compare:\n\tdata[" << (j - 1) << "] (= " << first[j - 1] << ")\n\twith\n\tdata[" << j << "] (= " << first[j] << ")" << std::endl;
 			}
 
-			if (!compare(comp, data[j - 1], data[j], false))
+			if (!compare(comp, first[j - 1], first[j], false))
 			{
 				if (PRINT_INFO)
 				{
-					std::cerr << "Swap:\n\tdata[" << (j - 1) << "] (= " << data[j - 1] << ")\n\twith\n\tdata[" << j << "] (= " << data[j] << ")" << std::endl;
+					std::cerr << "Swap:\n\tdata[" << (j - 1) << "] (= " << first[j - 1] << ")\n\twith\n\tdata[" << j << "] (= " << first[j] << ")" << std::endl;
 				}
 
 				stats->swaps++;
 
-				swap<t>(data, j, j - 1);
+				swap(first, j, j - 1);
 				j--;
 			}
 			else
@@ -110,63 +179,431 @@ Stats* insertion_sort(std::vector<t> &data, Comparator::Comparator comp)
 }
 
 template <class t>
-Stats* merge_sort(std::vector<t> &data, Comparator::Comparator comp)
+Stats* insertion_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return insertion_sort(data.begin(), data.end(), comp);
+}
+
+// Position in [lo, hi) after every element not after value, found with binary search
+template <class it_t, class t>
+size_t insertion_point(it_t data, size_t lo, size_t hi, const t &value, Comparator::Comparator comp, Stats* stats)
+{
+	while (lo < hi)
+	{
+		size_t middle = lo + (hi - lo) / 2;
+
+		stats->compares++;
+
+		if (compare(comp, value, data[middle], true))
+		{
+			hi = middle;
+		}
+		else
+		{
+			lo = middle + 1;
+		}
+	}
+
+	return lo;
+}
+
+// Insertion sort that finds the place of every element with binary search and then shifts the
+// elements after it as one block (a memmove for trivially copyable types), so it needs only
+// O(n log n) compares. Every element shifted counts as a swap.
+template <class it_t>
+Stats* binary_insertion_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	for (size_t i = 1; i < size; i++)
+	{
+		size_t place = insertion_point(first, 0, i, first[i], comp, stats);
+
+		if (place < i)
+		{
+			t value = std::move(first[i]);
+			std::move_backward(first + place, first + i, first + i + 1);
+			first[place] = std::move(value);
+
+			stats->swaps += i - place;
+		}
+	}
+
+	return stats;
+}
+
+template <class t>
+Stats* binary_insertion_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return binary_insertion_sort(data.begin(), data.end(), comp);
+}
+
+// Ford-Johnson on positions into data. Elements are paired, the later of every pair is sorted
+// recursively and the earlier ones are binary-inserted in Jacobsthal order, where each search
+// only has to cover the chain up to the element's partner and so stays within 2^k - 1 elements.
+template <class it_t>
+void merge_insertion(it_t data, std::vector<size_t> &items, Comparator::Comparator comp, Stats* stats)
 {
-	Stats* stats = new Stats{ data.size(), 0, 0, 0.0 };
-	std::vector<t> secondary(data.size());
+	size_t size = items.size();
+
+	if (size < 2)
+	{
+		return;
+	}
 
-	for (size_t jump = 1; jump < data.size(); jump *= 2)
+	std::vector<size_t> later(size / 2), earlier(size / 2);
+	for (size_t p = 0; p < size / 2; p++)
 	{
-		for (size_t x = 0; x < data.size(); x += jump * 2)
+		size_t a = items[2 * p], b = items[2 * p + 1];
+
+		stats->compares++;
+
+		if (compare(comp, data[b], data[a], true))
 		{
-			size_t min = x;
-			size_t max = std::min(data.size(), (size_t)x + jump * 2);
+			std::swap(a, b);
+		}
+
+		earlier[p] = a;
+		later[p] = b;
+	}
+
+	std::vector<size_t> sorted_later = later;
+	merge_insertion(data, sorted_later, comp, stats);
+
+	// Partner of every later element, in the order they came out of the recursion
+	std::vector<size_t> pend(sorted_later.size());
+	for (size_t p = 0; p < sorted_later.size(); p++)
+	{
+		pend[p] = earlier[std::find(later.begin(), later.end(), sorted_later[p]) - later.begin()];
+	}
+
+	if (size % 2)
+	{
+		pend.push_back(items[size - 1]);
+	}
 
-			auto left = data.begin() + min;
-			auto right = data.begin() + std::min(data.size(), (size_t)x + jump);
-			auto end = data.begin() + max;
+	// The partner of the first later element goes in front of it without a compare
+	std::vector<size_t> chain;
+	chain.reserve(size);
+	chain.push_back(pend[0]);
+	chain.insert(chain.end(), sorted_later.begin(), sorted_later.end());
+
+	size_t done = 1, bound = 1, next_bound = 3;
+	while (done < pend.size())
+	{
+		size_t group_end = std::min(next_bound, pend.size());
 
-			auto i = left;
-			auto j = right;
+		for (size_t i = group_end; i-- > done;)
+		{
+			// Everything up to the partner, the whole chain for the element without one
+			size_t lo = 0;
+			size_t hi = (i < sorted_later.size()) ? std::find(chain.begin(), chain.end(), sorted_later[i]) - chain.begin() : chain.size();
 
-			for (size_t it = min; it < max; it++)
+			while (lo < hi)
 			{
-				if (i != right && j != end)
-				{
-					if (PRINT_INFO)
-					{
-						std::cerr << "Compare:\n\tdata[" << (i - data.begin()) << "] (= " << *i << ")\n\twith\n\tdata[" << (j - data.begin()) << "] (= " << *j << ")" << std::endl;
-					}
+				size_t middle = lo + (hi - lo) / 2;
 
-					stats->compares++;
-				}
+				stats->compares++;
 
-				if (i != right && (j == end || compare(comp, *i, *j, false)))
-				{
-					stats->swaps++;
+				if (compare(comp, data[pend[i]], data[chain[middle]], true)) hi = middle;
+				else lo = middle + 1;
+			}
 
-					secondary[it] = *i;
-					i++;
-				}
-				else
-				{
-					stats->swaps++;
+			chain.insert(chain.begin() + lo, pend[i]);
+		}
 
-					secondary[it] = *j;
-					j++;
+		done = group_end;
+
+		size_t jacobsthal = next_bound + 2 * bound;
+		bound = next_bound;
+		next_bound = jacobsthal;
+	}
+
+	items.swap(chain);
+}
+
+// Fewest compares of the sorts here for small inputs, meant for comparators far more expensive than moves
+template <class it_t>
+Stats* merge_insertion_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	std::vector<size_t> items(size);
+	for (size_t i = 0; i < size; i++)
+	{
+		items[i] = i;
+	}
+
+	merge_insertion(first, items, comp, stats);
+
+	std::vector<t> sorted;
+	sorted.reserve(size);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		sorted.push_back(std::move(first[items[i]]));
+	}
+
+	std::move(sorted.begin(), sorted.end(), first);
+	stats->swaps += size;
+
+	return stats;
+}
+
+template <class t>
+Stats* merge_insertion_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return merge_insertion_sort(data.begin(), data.end(), comp);
+}
+
+// Merges the runs [min, mid) and [mid, max) of src into dst.
+// With count_moves every element written counts as a swap (merge_sort),
+// otherwise only elements taken from the right run over a non-empty left run do (hybrid_sort).
+template <class in_t, class out_t>
+void merge_runs(in_t src, out_t dst, size_t min, size_t mid, size_t max, Comparator::Comparator comp, Stats* stats, bool count_moves)
+{
+	auto left = src + min;
+	auto right = src + mid;
+	auto end = src + max;
+
+	auto i = left;
+	auto j = right;
+
+	for (size_t it = min; it < max; it++)
+	{
+		if (i != right && j != end)
+		{
+			if (PRINT_INFO)
+			{
+				std::cerr << "Compare:\n\tdata[" << (i - src) << "] (= " << *i << ")\n\twith\n\tdata[" << (j - src) << "] (= " << *j << ")" << std::endl;
+			}
+
+			stats->compares++;
+		}
+
+		if (i != right && (j == end || compare(comp, *i, *j, false)))
+		{
+			if (count_moves) stats->swaps++;
+
+			dst[it] = *i;
+			i++;
+		}
+		else
+		{
+			if (count_moves || i != right)
+			{
+				if (PRINT_INFO && !count_moves)
+				{
+					std::cerr << "Swap:\n\tdata[" << (i - src) << "] (= " << *i << ")\n\twith\n\tdata[" << (j - src) << "] (= " << *j << ")" << std::endl;
 				}
+
+				stats->swaps++;
 			}
+
+			dst[it] = *j;
+			j++;
+		}
+	}
+}
+
+// Pointers and vector iterators can be handed to the vectorized merge
+template <class it_t>
+struct contiguous_iterator : std::integral_constant<bool, std::is_pointer<it_t>::value ||
+	std::is_same<it_t, typename std::vector<typename std::iterator_traits<it_t>::value_type>::iterator>::value> {};
+
+struct IncreasingOrder
+{
+	template <class t>
+	static bool before(const t &a, const t &b) { return a < b; }
+};
+
+struct DecreasingOrder
+{
+	template <class t>
+	static bool before(const t &a, const t &b) { return a > b; }
+};
+
+// The merge kernels below make no per-element decisions, so the counters are derived from where
+// the run that empties first ends up, which matches what merge_runs would have counted
+template <class in_t>
+void count_merge(in_t a, size_t na, in_t b, size_t nb, Comparator::Comparator comp, Stats* stats, bool count_moves)
+{
+	typedef typename std::iterator_traits<in_t>::value_type t;
+
+	auto before = [comp](const t &x, const t &y) { return compare(comp, x, y, true); };
+
+	size_t taken_right;
+	if (!before(b[nb - 1], a[na - 1]))
+	{
+		taken_right = std::lower_bound(b, b + nb, a[na - 1], before) - b;
+		stats->compares += na + taken_right;
+	}
+	else
+	{
+		taken_right = nb;
+		stats->compares += nb + (std::upper_bound(a, a + na, b[nb - 1], before) - a);
+	}
+
+	stats->swaps += count_moves ? (na + nb) : taken_right;
+}
+
+// Merges two runs of n elements each from both ends at once (parity merge). After n steps from
+// each end every element has been written, so no step needs a bounds check. The selects compile
+// to conditional moves for arithmetic types. Ties go to the left run at the front and to the
+// right run at the back, which keeps the merge stable.
+template <class order, class in_t, class out_t>
+void parity_merge(in_t src, out_t dst, size_t min, size_t n)
+{
+	size_t i = min, j = min + n;
+	size_t i_end = min + n - 1, j_end = min + 2 * n - 1;
+	size_t lo = min, hi = min + 2 * n - 1;
+
+	for (size_t k = 0; k < n; k++)
+	{
+		bool right = order::before(src[j], src[i]);
+		dst[lo++] = right ? src[j] : src[i];
+		j += right;
+		i += !right;
+
+		bool left = order::before(src[j_end], src[i_end]);
+		dst[hi--] = left ? src[i_end] : src[j_end];
+		i_end -= left;
+		j_end -= !left;
+	}
+}
+
+template <class in_t, class out_t>
+void merge_runs_dispatch(in_t src, out_t dst, size_t min, size_t mid, size_t max, Comparator::Comparator comp, Stats* stats, bool count_moves, std::false_type)
+{
+	size_t n = mid - min;
+
+	if (n == 0 || n != max - mid || PRINT_INFO || comp == Comparator::NONE)
+	{
+		merge_runs(src, dst, min, mid, max, comp, stats, count_moves);
+		return;
+	}
+
+	count_merge(src + min, n, src + mid, n, comp, stats, count_moves);
+
+	if (comp == Comparator::INCREASING)
+	{
+		parity_merge<IncreasingOrder>(src, dst, min, n);
+	}
+	else
+	{
+		parity_merge<DecreasingOrder>(src, dst, min, n);
+	}
+}
+
+template <class in_t, class out_t>
+void merge_runs_dispatch(in_t src, out_t dst, size_t min, size_t mid, size_t max, Comparator::Comparator comp, Stats* stats, bool count_moves, std::true_type)
+{
+	size_t na = mid - min;
+	size_t nb = max - mid;
+
+	if (na < 8 || nb < 8 || PRINT_INFO || comp == Comparator::NONE || !simd_merge_enabled())
+	{
+		merge_runs_dispatch(src, dst, min, mid, max, comp, stats, count_moves, std::false_type());
+		return;
+	}
+
+	count_merge(&*(src + min), na, &*(src + mid), nb, comp, stats, count_moves);
+	simd_merge(&*(src + min), na, &*(src + mid), nb, &*(dst + min), comp == Comparator::DECREASING);
+}
+
+// Merges two separately stored sorted runs into out
+template <class t>
+void merge_sorted_runs(const t* a, size_t na, const t* b, size_t nb, t* out, bool desc, std::true_type)
+{
+	simd_merge(a, na, b, nb, out, desc);
+}
+
+template <class t>
+void merge_sorted_runs(const t* a, size_t na, const t* b, size_t nb, t* out, bool desc, std::false_type)
+{
+	if (desc)
+	{
+		merge_scalar<t, true>(a, a + na, b, b + nb, b + nb, b + nb, out);
+	}
+	else
+	{
+		merge_scalar<t, false>(a, a + na, b, b + nb, b + nb, b + nb, out);
+	}
+}
+
+// Merges every pair of neighbouring runs of length jump from src into dst
+template <class in_t, class out_t>
+void merge_pass(in_t src, out_t dst, size_t size, size_t jump, Comparator::Comparator comp, Stats* stats, bool count_moves)
+{
+	typedef typename std::iterator_traits<in_t>::value_type t;
+	typedef std::integral_constant<bool, simd_mergeable<t>::value && contiguous_iterator<in_t>::value && contiguous_iterator<out_t>::value> vectorized;
+
+	for (size_t x = 0; x < size; x += jump * 2)
+	{
+		size_t mid = std::min(size, (size_t)x + jump);
+		size_t max = std::min(size, (size_t)x + jump * 2);
+
+		merge_runs_dispatch(src, dst, x, mid, max, comp, stats, count_moves, vectorized());
+	}
+}
+
+// Runs the merge passes from width jump upwards over size elements, alternating between the range and buffer.
+template <class it_t, class buf_t>
+void merge_levels(it_t first, size_t size, buf_t buffer, size_t jump, Comparator::Comparator comp, Stats* stats, bool count_moves)
+{
+	bool in_buffer = false;
+
+	for (; jump < size; jump *= 2)
+	{
+		if (in_buffer)
+		{
+			merge_pass(buffer, first, size, jump, comp, stats, count_moves);
 		}
+		else
+		{
+			merge_pass(first, buffer, size, jump, comp, stats, count_moves);
+		}
+
+		in_buffer = !in_buffer;
+	}
 
-		data.swap(secondary);
+	if (in_buffer)
+	{
+		std::move(buffer, buffer + size, first);
 	}
+}
+
+template <class it_t>
+Stats* merge_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+	std::vector<t> secondary(size);
+
+	merge_levels(first, size, secondary.begin(), 1, comp, stats, true);
 
 	return stats;
 }
 
 template <class t>
-size_t partition(std::vector<t> &data, Comparator::Comparator comp, Stats* stats, Range range)
+Stats* merge_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return merge_sort(data.begin(), data.end(), comp);
+}
+
+template <class it_t>
+size_t partition(it_t data, Comparator::Comparator comp, Stats* stats, Range range)
 {
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
 	size_t p_index = (rand() % (range.hi - range.lo)) + range.lo;
 	t pivot = data[p_index];
 	swap(data, range.lo, p_index);
@@ -204,12 +641,24 @@ size_t partition(std::vector<t> &data, Comparator::Comparator comp, Stats* stats
 }
 
 template <class t>
-Stats* quick_sort(std::vector<t> &data, Comparator::Comparator comp)
+size_t partition(std::vector<t> &data, Comparator::Comparator comp, Stats* stats, Range range)
+{
+	return partition(data.begin(), comp, stats, range);
+}
+
+template <class it_t>
+Stats* quick_sort(it_t first, it_t last, Comparator::Comparator comp)
 {
-	Stats* stats = new Stats{ data.size(), 0, 0, 0.0 };
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
 	std::stack<Range> sort_ranges;
 
-	sort_ranges.push({ 0, data.size() - 1 });
+	if (size < 2)
+	{
+		return stats;
+	}
+
+	sort_ranges.push({ 0, size - 1 });
 	while (!sort_ranges.empty())
 	{
 		Range range = sort_ranges.top();
@@ -217,7 +666,7 @@ Stats* quick_sort(std::vector<t> &data, Comparator::Comparator comp)
 
 		if (range.lo < range.hi)
 		{
-			size_t middle = partition(data, comp, stats, range);
+			size_t middle = partition(first, comp, stats, range);
 			if (middle > 0) sort_ranges.push({ range.lo, middle - 1 });
 			sort_ranges.push({ middle + 1, range.hi });
 		}
@@ -227,28 +676,47 @@ Stats* quick_sort(std::vector<t> &data, Comparator::Comparator comp)
 }
 
 template <class t>
-void quick_sort_rec_inner(std::vector<t> &data, Comparator::Comparator comp, Range range, Stats* stats)
+Stats* quick_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return quick_sort(data.begin(), data.end(), comp);
+}
+
+template <class it_t>
+void quick_sort_rec_inner(it_t data, Comparator::Comparator comp, Range range, Stats* stats)
 {
 	if (range.lo < range.hi)
 	{
-		size_t middle = partition<t>(data, comp, stats, range);
-		if (middle > 0) quick_sort_rec_inner<t>(data, comp, { range.lo, middle - 1 }, stats);
-		quick_sort_rec_inner<t>(data, comp, { middle + 1, range.hi }, stats);
+		size_t middle = partition(data, comp, stats, range);
+		if (middle > 0) quick_sort_rec_inner(data, comp, { range.lo, middle - 1 }, stats);
+		quick_sort_rec_inner(data, comp, { middle + 1, range.hi }, stats);
 	}
 }
 
-template <class t>
-Stats* quick_sort_rec(std::vector<t> &data, Comparator::Comparator comp)
+template <class it_t>
+Stats* quick_sort_rec(it_t first, it_t last, Comparator::Comparator comp)
 {
-	Stats* stats = new Stats{ data.size(), 0, 0, 0.0 };
-	quick_sort_rec_inner(data, comp, { 0, data.size() - 1 }, stats);
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	if (size > 1)
+	{
+		quick_sort_rec_inner(first, comp, { 0, size - 1 }, stats);
+	}
 
 	return stats;
 }
 
 template <class t>
-bool dual_pivot_partition(std::vector<t> &data, Comparator::Comparator comp, Stats* stats, Range range, size_t &p, size_t &q)
+Stats* quick_sort_rec(std::vector<t> &data, Comparator::Comparator comp)
 {
+	return quick_sort_rec(data.begin(), data.end(), comp);
+}
+
+template <class it_t>
+bool dual_pivot_partition(it_t data, Comparator::Comparator comp, Stats* stats, Range range, size_t &p, size_t &q)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
 	if (PRINT_INFO)
 	{
 		std::cerr << "Selecting pivots..." << std::endl;
@@ -277,7 +745,7 @@ bool dual_pivot_partition(std::vector<t> &data, Comparator::Comparator comp, Sta
 	stats->swaps++;
 	stats->compares++;
 
-	if (!compare(comp, data[pivot1_index], data[pivot2_index], true))
+	if (!compare(comp, data[range.lo], data[range.hi], true))
 	{
 		swap(data, range.lo, range.hi);
 
@@ -430,12 +898,18 @@ bool dual_pivot_partition(std::vector<t> &data, Comparator::Comparator comp, Sta
 }
 
 template <class t>
-void dual_pivot_quick_sort_inner(std::vector<t> &data, Comparator::Comparator comp, Range range, Stats* stats)
+bool dual_pivot_partition(std::vector<t> &data, Comparator::Comparator comp, Stats* stats, Range range, size_t &p, size_t &q)
+{
+	return dual_pivot_partition(data.begin(), comp, stats, range, p, q);
+}
+
+template <class it_t>
+void dual_pivot_quick_sort_inner(it_t data, Comparator::Comparator comp, Range range, Stats* stats)
 {
 	if (range.lo < range.hi)
 	{
 		size_t p, q;
-		if (dual_pivot_partition<t>(data, comp, stats, range, p, q))
+		if (dual_pivot_partition(data, comp, stats, range, p, q))
 		{
 			if (p > 0) dual_pivot_quick_sort_inner(data, comp, { range.lo, p - 1 }, stats);
 			if (q > 0) dual_pivot_quick_sort_inner(data, comp, { p + 1, q - 1 }, stats);
@@ -444,27 +918,129 @@ void dual_pivot_quick_sort_inner(std::vector<t> &data, Comparator::Comparator co
 	}
 }
 
-template <class t>
-Stats* dual_pivot_quick_sort(std::vector<t> &data, Comparator::Comparator comp)
+template <class it_t>
+Stats* dual_pivot_quick_sort(it_t first, it_t last, Comparator::Comparator comp)
 {
-	Stats* stats = new Stats{ data.size(), 0, 0, 0.0 };
-	dual_pivot_quick_sort_inner(data, comp, { 0, data.size() - 1 }, stats);
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
 
-	return stats;
-}
+	if (size > 1)
+	{
+		dual_pivot_quick_sort_inner(first, comp, { 0, size - 1 }, stats);
+	}
+
+	return stats;
+}
 
 template <class t>
-Stats* hybrid_sort(std::vector<t> &data, Comparator::Comparator comp)
+Stats* dual_pivot_quick_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return dual_pivot_quick_sort(data.begin(), data.end(), comp);
+}
+
+// Bottom-up sift-down (Floyd) in a HEAP_ARITY-ary heap of size elements, latest element at the root.
+// The hole left by data[i] is first walked down along the latest children to a leaf, which costs
+// arity - 1 compares per level, and the sifted element is then placed by climbing back up, which
+// usually takes only one or two compares since it came from the bottom of the heap.
+template <class it_t>
+void heap_sift(it_t data, size_t size, size_t i, Comparator::Comparator comp, Stats* stats)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	size_t j = i;
+	size_t child;
+
+	while ((child = HEAP_ARITY * j + 1) < size)
+	{
+		size_t latest = child;
+		size_t last = std::min(size, child + HEAP_ARITY);
+
+		for (size_t c = child + 1; c < last; c++)
+		{
+			stats->compares++;
+
+			if (compare(comp, data[latest], data[c], true)) latest = c;
+		}
+
+		j = latest;
+	}
+
+	while (j > i)
+	{
+		stats->compares++;
+
+		if (!compare(comp, data[j], data[i], true)) break;
+
+		j = (j - 1) / HEAP_ARITY;
+	}
+
+	// Everything on the path from i to j moves up a level and data[i] takes the place of j
+	t carry = std::move(data[i]);
+	while (j > i)
+	{
+		stats->swaps++;
+
+		std::swap(carry, data[j]);
+		j = (j - 1) / HEAP_ARITY;
+	}
+
+	data[i] = std::move(carry);
+}
+
+// Heapsorts [range.lo, range.hi] in place, O(n log n) in the worst case with O(1) extra memory
+template <class it_t>
+void heap_sort_inner(it_t data, Comparator::Comparator comp, Stats* stats, Range range)
+{
+	it_t first = data + range.lo;
+	size_t size = range.hi - range.lo + 1;
+
+	if (size < 2)
+	{
+		return;
+	}
+
+	for (size_t i = (size - 2) / HEAP_ARITY + 1; i-- > 0;)
+	{
+		heap_sift(first, size, i, comp, stats);
+	}
+
+	for (size_t end = size - 1; end > 0; end--)
+	{
+		stats->swaps++;
+
+		swap(first, 0, end);
+		heap_sift(first, end, 0, comp, stats);
+	}
+}
+
+template <class it_t>
+Stats* heap_sort(it_t first, it_t last, Comparator::Comparator comp)
 {
-	Stats* stats = new Stats{ data.size(), 0, 0, 0.0 };
-	std::vector<t> secondary(data.size());
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	if (size > 1)
+	{
+		heap_sort_inner(first, comp, stats, { 0, size - 1 });
+	}
 
-	size_t jump = 10;
+	return stats;
+}
+
+template <class t>
+Stats* heap_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return heap_sort(data.begin(), data.end(), comp);
+}
 
-	for (size_t x = 0; x < data.size(); x += jump)
+// Sorts every block of jump elements with insertion sort
+template <class it_t>
+void insertion_blocks(it_t first, size_t size, size_t jump, Comparator::Comparator comp, Stats* stats)
+{
+	for (size_t x = 0; x < size; x += jump)
 	{
 		size_t i, j;
-		size_t max = std::min(data.size(), x + jump);
+		size_t max = std::min(size, x + jump);
 
 		for (i = x + 1; i < max; i++)
 		{
@@ -474,11 +1050,11 @@ Stats* hybrid_sort(std::vector<t> &data, Comparator::Comparator comp)
 			{
 				stats->compares++;
 
-				if (!compare(comp, data[j - 1], data[j], false))
+				if (!compare(comp, first[j - 1], first[j], false))
 				{
 					stats->swaps++;
 
-					swap<t>(data, j, j - 1);
+					swap(first, j, j - 1);
 					j--;
 				}
 				else
@@ -488,202 +1064,1082 @@ Stats* hybrid_sort(std::vector<t> &data, Comparator::Comparator comp)
 			}
 		}
 	}
+}
 
+// Quick sort on partition() that hands a range to heap_sort_inner once it has been partitioned
+// 2 log2(n) times without getting small, so bad pivots cannot make it quadratic
+template <class it_t>
+Stats* intro_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+	std::stack<std::pair<Range, int>> sort_ranges;
 
-	for (; jump < data.size(); jump *= 2)
+	if (size < 2)
 	{
-		for (size_t x = 0; x < data.size(); x += jump * 2)
-		{
-			size_t min = x;
-			size_t max = std::min(data.size(), (size_t)x + jump * 2);
+		return stats;
+	}
+
+	int depth = 0;
+	for (size_t n = size; n > 1; n /= 2) depth += 2;
 
-			auto left = data.begin() + min;
-			auto right = data.begin() + std::min(data.size(), (size_t)x + jump);
-			auto end = data.begin() + max;
+	sort_ranges.push({ { 0, size - 1 }, depth });
+	while (!sort_ranges.empty())
+	{
+		Range range = sort_ranges.top().first;
+		int budget = sort_ranges.top().second;
+		sort_ranges.pop();
 
-			auto i = left;
-			auto j = right;
+		if (range.hi - range.lo < 10)
+		{
+			insertion_blocks(first + range.lo, range.hi - range.lo + 1, range.hi - range.lo + 1, comp, stats);
+		}
+		else if (budget == 0)
+		{
+			heap_sort_inner(first, comp, stats, range);
+		}
+		else
+		{
+			size_t middle = partition(first, comp, stats, range);
+			if (middle > range.lo) sort_ranges.push({ { range.lo, middle - 1 }, budget - 1 });
+			if (middle < range.hi) sort_ranges.push({ { middle + 1, range.hi }, budget - 1 });
+		}
+	}
 
-			for (size_t it = min; it < max; it++)
-			{
-				if (i != right && j != end)
-				{
-					if (PRINT_INFO)
-					{
-						std::cerr << "Compare:\n\tdata[" << (i - data.begin()) << "] (= " << *i << ")\n\twith\n\tdata[" << (j - data.begin()) << "] (= " << *j << ")" << std::endl;
-					}
+	return stats;
+}
 
-					stats->compares++;
-				}
+template <class t>
+Stats* intro_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return intro_sort(data.begin(), data.end(), comp);
+}
 
-				if (i != right && (j == end || compare(comp, *i, *j, false)))
-				{
-					secondary[it] = *i;
-					i++;
-				}
-				else
-				{
-					if (i != right)
-					{
-						if (PRINT_INFO)
-						{
-							std::cerr << "Swap:\n\tdata[" << (i - data.begin()) << "] (= " << *i << ")\n\twith\n\tdata[" << (j - data.begin()) << "] (= " << *j << ")" << std::endl;
-						}
+template <class it_t>
+Stats* hybrid_sort_test(it_t first, it_t last, Comparator::Comparator comp, size_t cut_off)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
 
-						stats->swaps++;
-					}
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+	std::vector<t> secondary(size);
 
-					secondary[it] = *j;
-					j++;
-				}
-			}
-		}
+	// Tiles hold a power of two number of insertion blocks, so their borders line up with the
+	// global runs and the merges done are exactly the same as without tiling
+	size_t tile = cut_off;
+	while (tile * 2 * 2 * sizeof(t) <= cache_size(2))
+	{
+		tile *= 2;
+	}
 
-		data.swap(secondary);
+	for (size_t x = 0; x < size; x += tile)
+	{
+		size_t tile_size = std::min(tile, size - x);
+
+		insertion_blocks(first + x, tile_size, cut_off, comp, stats);
+		merge_levels(first + x, tile_size, secondary.begin() + x, cut_off, comp, stats, false);
 	}
 
+	merge_levels(first, size, secondary.begin(), tile, comp, stats, false);
+
 	return stats;
 }
 
 template <class t>
 Stats* hybrid_sort_test(std::vector<t> &data, Comparator::Comparator comp, size_t cut_off)
 {
-	Stats* stats = new Stats{ data.size(), 0, 0, 0.0 };
-	std::vector<t> secondary(data.size());
+	return hybrid_sort_test(data.begin(), data.end(), comp, cut_off);
+}
+
+template <class it_t>
+Stats* hybrid_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	return hybrid_sort_test(first, last, comp, 10);
+}
+
+template <class t>
+Stats* hybrid_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return hybrid_sort(data.begin(), data.end(), comp);
+}
 
-	size_t jump = cut_off;
+// Stable merge of [lo, mid) and [mid, hi) with at most buffer.size() elements of extra memory.
+// When the shorter run fits into the buffer it is moved out and merged back in one pass, otherwise
+// the longer run is cut in half, the matching cut in the other run is found with binary search and
+// rotating the middle part leaves two independent, smaller merges.
+template <class it_t, class buf_t>
+void block_merge(it_t data, size_t lo, size_t mid, size_t hi, buf_t &buffer, Comparator::Comparator comp, Stats* stats)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
 
-	for (size_t x = 0; x < data.size(); x += jump)
+	auto before = [comp, stats](const t &x, const t &y)
 	{
-		size_t i, j;
-		size_t max = std::min(data.size(), x + jump);
+		stats->compares++;
+		return compare(comp, x, y, true);
+	};
 
-		for (i = x + 1; i < max; i++)
-		{
-			j = i;
+	if (lo == mid || mid == hi)
+	{
+		return;
+	}
 
-			while (j > x)
-			{
-				stats->compares++;
+	// Already in order, nothing to do
+	if (!before(data[mid], data[mid - 1]))
+	{
+		return;
+	}
 
-				if (!compare(comp, data[j - 1], data[j], false))
-				{
-					stats->swaps++;
+	size_t na = mid - lo, nb = hi - mid;
 
-					swap<t>(data, j, j - 1);
-					j--;
-				}
-				else
-				{
-					break;
-				}
-			}
+	if (na <= buffer.size())
+	{
+		std::move(data + lo, data + mid, buffer.begin());
+
+		size_t a = 0, b = mid, out = lo;
+		while (a < na && b < hi)
+		{
+			data[out++] = before(data[b], buffer[a]) ? std::move(data[b++]) : std::move(buffer[a++]);
 		}
+
+		std::move(buffer.begin() + a, buffer.begin() + na, data + out);
+		stats->swaps += na + (out - lo);
 	}
+	else if (nb <= buffer.size())
+	{
+		std::move(data + mid, data + hi, buffer.begin());
 
+		size_t a = mid, b = nb, out = hi;
+		while (a > lo && b > 0)
+		{
+			data[--out] = before(buffer[b - 1], data[a - 1]) ? std::move(data[--a]) : std::move(buffer[--b]);
+		}
 
-	for (; jump < data.size(); jump *= 2)
+		std::move(buffer.begin(), buffer.begin() + b, data + (out - b));
+		stats->swaps += nb + (hi - out);
+	}
+	else
 	{
-		for (size_t x = 0; x < data.size(); x += jump * 2)
+		size_t cut1, cut2;
+
+		// Equal elements stay on the side of the cut they came from, which keeps the merge stable
+		if (na >= nb)
 		{
-			size_t min = x;
-			size_t max = std::min(data.size(), (size_t)x + jump * 2);
+			cut1 = lo + na / 2;
+			cut2 = std::lower_bound(data + mid, data + hi, data[cut1], before) - data;
+		}
+		else
+		{
+			cut2 = mid + nb / 2;
+			cut1 = std::upper_bound(data + lo, data + mid, data[cut2], before) - data;
+		}
 
-			auto left = data.begin() + min;
-			auto right = data.begin() + std::min(data.size(), (size_t)x + jump);
-			auto end = data.begin() + max;
+		std::rotate(data + cut1, data + mid, data + cut2);
+		stats->swaps += cut2 - cut1;
 
-			auto i = left;
-			auto j = right;
+		size_t new_mid = cut1 + (cut2 - mid);
+		block_merge(data, lo, cut1, new_mid, buffer, comp, stats);
+		block_merge(data, new_mid, cut2, hi, buffer, comp, stats);
+	}
+}
 
-			for (size_t it = min; it < max; it++)
-			{
-				if (i != right && j != end)
-				{
-					if (PRINT_INFO)
-					{
-						std::cerr << "Compare:\n\tdata[" << (i - data.begin()) << "] (= " << *i << ")\n\twith\n\tdata[" << (j - data.begin()) << "] (= " << *j << ")" << std::endl;
-					}
+// Stable merge sort that needs only a buffer of sqrt(n) elements instead of a full secondary copy
+template <class it_t>
+Stats* block_merge_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
 
-					stats->compares++;
-				}
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
 
-				if (i != right && (j == end || compare(comp, *i, *j, false)))
-				{
-					secondary[it] = *i;
-					i++;
-				}
-				else
-				{
-					if (i != right)
-					{
-						if (PRINT_INFO)
-						{
-							std::cerr << "Swap:\n\tdata[" << (i - data.begin()) << "] (= " << *i << ")\n\twith\n\tdata[" << (j - data.begin()) << "] (= " << *j << ")" << std::endl;
-						}
+	size_t buffer_size = 1;
+	while (buffer_size * buffer_size < size) buffer_size++;
 
-						stats->swaps++;
-					}
+	std::vector<t> buffer(buffer_size);
 
-					secondary[it] = *j;
-					j++;
-				}
-			}
-		}
+	insertion_blocks(first, size, 16, comp, stats);
 
-		data.swap(secondary);
+	for (size_t run = 16; run < size; run *= 2)
+	{
+		for (size_t lo = 0; lo + run < size; lo += 2 * run)
+		{
+			block_merge(first, lo, lo + run, std::min(size, lo + 2 * run), buffer, comp, stats);
+		}
 	}
 
 	return stats;
 }
 
-void count_sort(std::vector<int> &data, int exp, int base, Stats* stats)
+template <class t>
+Stats* block_merge_sort(std::vector<t> &data, Comparator::Comparator comp)
 {
-	std::vector<int> secondary(data.size());
-	std::vector<int> count(base);
+	return block_merge_sort(data.begin(), data.end(), comp);
+}
 
-	for (auto it = count.begin(); it != count.end(); it++)
+// Tournament over up to ways runs of src. Every internal node keeps the run that lost the
+// match played there, so replacing the winner only replays the matches on its own path.
+template <class order, class in_t>
+struct LoserTree
+{
+	typedef typename std::iterator_traits<in_t>::value_type t;
+
+	in_t src;
+	long long compares;
+	size_t leaves, winner;
+	std::vector<size_t> pos, end, loser, winners;
+	std::vector<t> head;
+	std::vector<char> done;
+
+	LoserTree(in_t src, size_t ways) : src(src), compares(0), winner(0)
 	{
-		*it = 0;
+		for (leaves = 1; leaves < ways; leaves *= 2);
+
+		pos.resize(leaves);
+		end.resize(leaves);
+		loser.resize(leaves);
+		winners.resize(leaves * 2);
+		head.resize(leaves);
+		done.resize(leaves);
 	}
 
-	for (auto it = data.begin(); it != data.end(); it++)
+	void load(size_t run)
 	{
-		count[(*it / exp) % base]++;
+		done[run] = pos[run] == end[run];
+
+		if (!done[run])
+		{
+			head[run] = src[pos[run]];
+		}
 	}
 
-	for (auto it = count.begin() + 1; it != count.end(); it++)
+	// Ties go to the run further left, which keeps the merge stable. Which run wins is
+	// unpredictable, so both the match and the replay below are written without branches.
+	bool wins(size_t a, size_t b)
 	{
-		*it += *(it - 1);
+		bool left = a < b;
+		size_t x = left ? b : a;
+		size_t y = left ? a : b;
+		bool played = !(done[a] | done[b]);
+
+		compares += played;
+
+		return played ? (order::before(head[x], head[y]) != left) : (done[b] && !done[a]);
 	}
 
-	for (int i = data.size() - 1; i >= 0; i--)
+	void build()
 	{
-		stats->swaps++;
+		for (size_t i = 0; i < leaves; i++)
+		{
+			load(i);
+			winners[leaves + i] = i;
+		}
+
+		for (size_t node = leaves - 1; node > 0; node--)
+		{
+			size_t a = winners[node * 2];
+			size_t b = winners[node * 2 + 1];
+
+			if (wins(a, b))
+			{
+				winners[node] = a;
+				loser[node] = b;
+			}
+			else
+			{
+				winners[node] = b;
+				loser[node] = a;
+			}
+		}
+
+		winner = winners[1];
+	}
+
+	// Hands out the head of the winning run and replays its path with the run's next element
+	void pop(t &out)
+	{
+		out = std::move(head[winner]);
+		pos[winner]++;
+		load(winner);
+
+		for (size_t node = (winner + leaves) / 2; node > 0; node /= 2)
+		{
+			size_t other = loser[node];
+			bool lost = wins(other, winner);
+
+			loser[node] = lost ? winner : other;
+			winner = lost ? other : winner;
+		}
+	}
+};
 
-		secondary[count[(data[i] / exp) % base] - 1] = data[i];
-		count[(data[i] / exp) % base]--;
+// Merges every group of ways neighbouring runs of length run from src into dst
+template <class order, class in_t, class out_t>
+void multiway_merge_pass(in_t src, out_t dst, size_t size, size_t run, size_t ways, Stats* stats)
+{
+	LoserTree<order, in_t> tree(src, ways);
+
+	for (size_t x = 0; x < size; x += run * ways)
+	{
+		for (size_t r = 0; r < tree.leaves; r++)
+		{
+			tree.pos[r] = std::min(size, x + r * run);
+			tree.end[r] = (r < ways) ? std::min(size, x + (r + 1) * run) : tree.pos[r];
+		}
+
+		size_t max = std::min(size, x + run * ways);
+		tree.build();
+
+		for (size_t it = x; it < max; it++)
+		{
+			tree.pop(dst[it]);
+		}
+
+		stats->swaps += max - x;
 	}
 
-	data.swap(secondary);
+	stats->compares += tree.compares;
 }
 
-Stats* radix_sort(std::vector<int> &data, Comparator::Comparator comp)
+template <class in_t, class out_t>
+void multiway_merge_pass(in_t src, out_t dst, size_t size, size_t run, size_t ways, Comparator::Comparator comp, Stats* stats)
+{
+	if (comp == Comparator::DECREASING)
+	{
+		multiway_merge_pass<DecreasingOrder>(src, dst, size, run, ways, stats);
+	}
+	else
+	{
+		multiway_merge_pass<IncreasingOrder>(src, dst, size, run, ways, stats);
+	}
+}
+
+// Merges ways runs at a time, so the data is streamed through memory log_ways(n) times instead of log_2(n)
+template <class it_t>
+Stats* multiway_merge_sort(it_t first, it_t last, Comparator::Comparator comp, size_t ways = MULTIWAY_WAYS)
 {
-	Stats* stats = new Stats{ data.size(), 0, 0, 0.0 };
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+	std::vector<t> secondary(size);
+	bool in_secondary = false;
+
+	ways = std::max((size_t)2, ways);
+	insertion_blocks(first, size, 10, comp, stats);
 
-	int max = -1;
-	for (auto it = data.begin(); it != data.end(); it++)
+	for (size_t run = 10; run < size; run *= ways)
 	{
-		stats->compares++;
+		if (in_secondary)
+		{
+			multiway_merge_pass(secondary.begin(), first, size, run, ways, comp, stats);
+		}
+		else
+		{
+			multiway_merge_pass(first, secondary.begin(), size, run, ways, comp, stats);
+		}
 
-		if (!compare(comp, *it, max, false)) max = *it;
+		in_secondary = !in_secondary;
 	}
 
-	for (int exp = 1; max / exp > 0; exp = exp << 4)
+	if (in_secondary)
 	{
-		count_sort(data, exp, 16, stats);
+		std::move(secondary.begin(), secondary.end(), first);
 	}
 
 	return stats;
 }
+
+template <class t>
+Stats* multiway_merge_sort(std::vector<t> &data, Comparator::Comparator comp, size_t ways = MULTIWAY_WAYS)
+{
+	return multiway_merge_sort(data.begin(), data.end(), comp, ways);
+}
+
+// Runs f(0) .. f(threads - 1), the calling thread takes the first share
+template <class func_t>
+void run_parallel(size_t threads, func_t f)
+{
+	std::vector<std::thread> workers;
+
+	for (size_t id = 1; id < threads; id++)
+	{
+		workers.emplace_back(f, id);
+	}
+
+	f(0);
+
+	for (auto it = workers.begin(); it != workers.end(); it++)
+	{
+		it->join();
+	}
+}
+
+inline void add_stats(Stats* stats, const Stats &other)
+{
+	stats->compares += other.compares;
+	stats->swaps += other.swaps;
+}
+
+// Splitters kept as an implicit binary search tree, so finding the bucket of an element takes
+// log2(buckets) compares and no branches. Bucket b holds the elements in (splitter[b - 1], splitter[b]].
+template <class order, class t>
+struct SampleClassifier
+{
+	std::vector<t> tree;
+	size_t buckets;
+	int levels;
+
+	SampleClassifier(const std::vector<t> &splitters) : tree(splitters.size() + 1), buckets(splitters.size() + 1), levels(0)
+	{
+		while (((size_t)1 << levels) < buckets) levels++;
+
+		size_t next = 0;
+		build(splitters, next, 1);
+	}
+
+	void build(const std::vector<t> &splitters, size_t &next, size_t node)
+	{
+		if (node >= buckets) return;
+
+		build(splitters, next, 2 * node);
+		tree[node] = splitters[next++];
+		build(splitters, next, 2 * node + 1);
+	}
+
+	size_t classify(const t &value) const
+	{
+		size_t node = 1;
+
+		for (int l = 0; l < levels; l++)
+		{
+			node = 2 * node + (size_t)order::before(tree[node], value);
+		}
+
+		return node - buckets;
+	}
+};
+
+template <class order, class it_t>
+void sample_sort_inner(it_t first, size_t size, Comparator::Comparator comp, size_t threads, Stats* stats)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	if (size < SAMPLE_MIN_SIZE)
+	{
+		Stats* bucket = hybrid_sort(first, first + size, comp);
+		add_stats(stats, *bucket);
+		delete bucket;
+		return;
+	}
+
+	size_t buckets = SAMPLE_BUCKETS;
+	while (buckets > 2 && size < buckets * 64) buckets /= 2;
+
+	// Oversampled splitters, so the buckets come out close to the same size
+	std::minstd_rand random((unsigned int)size);
+	std::vector<t> sample(std::min(size, buckets * 8));
+
+	for (auto it = sample.begin(); it != sample.end(); it++)
+	{
+		*it = first[random() % size];
+	}
+
+	Stats* sample_stats = hybrid_sort(sample.begin(), sample.end(), comp);
+	add_stats(stats, *sample_stats);
+	delete sample_stats;
+
+	std::vector<t> splitters(buckets - 1);
+	for (size_t b = 0; b + 1 < buckets; b++)
+	{
+		splitters[b] = sample[(b + 1) * sample.size() / buckets];
+	}
+
+	SampleClassifier<order, t> classifier(splitters);
+
+	std::vector<unsigned char> oracle(size);
+	std::vector<size_t> counts(threads * buckets, 0);
+	size_t chunk = (size + threads - 1) / threads;
+
+	run_parallel(threads, [&](size_t id)
+	{
+		size_t lo = std::min(size, id * chunk), hi = std::min(size, lo + chunk);
+		size_t* count = &counts[id * buckets];
+
+		for (size_t i = lo; i < hi; i++)
+		{
+			size_t b = classifier.classify(first[i]);
+			oracle[i] = (unsigned char)b;
+			count[b]++;
+		}
+	});
+
+	// Every thread writes its share of a bucket right after the previous thread's share
+	std::vector<size_t> bucket_start(buckets + 1);
+	size_t sum = 0;
+
+	for (size_t b = 0; b < buckets; b++)
+	{
+		bucket_start[b] = sum;
+
+		for (size_t id = 0; id < threads; id++)
+		{
+			size_t count = counts[id * buckets + b];
+			counts[id * buckets + b] = sum;
+			sum += count;
+		}
+	}
+
+	bucket_start[buckets] = size;
+
+	std::vector<t> secondary(size);
+
+	run_parallel(threads, [&](size_t id)
+	{
+		size_t lo = std::min(size, id * chunk), hi = std::min(size, lo + chunk);
+		size_t* next = &counts[id * buckets];
+
+		for (size_t i = lo; i < hi; i++)
+		{
+			secondary[next[oracle[i]]++] = std::move(first[i]);
+		}
+	});
+
+	stats->compares += (long long)size * classifier.levels;
+	stats->swaps += (long long)size * 2;
+
+	// Buckets are handed out one at a time, so a large one does not hold up the rest
+	std::atomic<size_t> next_bucket(0);
+	std::vector<Stats> bucket_stats(threads, Stats{ 0, 0, 0, 0.0 });
+
+	run_parallel(threads, [&](size_t id)
+	{
+		for (size_t b = next_bucket++; b < buckets; b = next_bucket++)
+		{
+			size_t lo = bucket_start[b], hi = bucket_start[b + 1];
+			std::move(secondary.begin() + lo, secondary.begin() + hi, first + lo);
+
+			// Everything landed in one bucket, splitting again would not make progress
+			if (hi - lo == size)
+			{
+				Stats* bucket = hybrid_sort(first + lo, first + hi, comp);
+				add_stats(&bucket_stats[id], *bucket);
+				delete bucket;
+			}
+			else
+			{
+				sample_sort_inner<order>(first + lo, hi - lo, comp, 1, &bucket_stats[id]);
+			}
+		}
+	});
+
+	for (auto it = bucket_stats.begin(); it != bucket_stats.end(); it++)
+	{
+		add_stats(stats, *it);
+	}
+}
+
+// Parallel samplesort: the elements are classified against sampled splitters, scattered into
+// up to SAMPLE_BUCKETS buckets and the buckets are then sorted independently
+template <class it_t>
+Stats* sample_sort(it_t first, it_t last, Comparator::Comparator comp, size_t threads = SAMPLE_THREADS)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	if (comp == Comparator::DECREASING)
+	{
+		sample_sort_inner<DecreasingOrder>(first, size, comp, threads, stats);
+	}
+	else
+	{
+		sample_sort_inner<IncreasingOrder>(first, size, comp, threads, stats);
+	}
+
+	return stats;
+}
+
+template <class t>
+Stats* sample_sort(std::vector<t> &data, Comparator::Comparator comp, size_t threads = SAMPLE_THREADS)
+{
+	return sample_sort(data.begin(), data.end(), comp, threads);
+}
+
+// Digits are taken from the offset of each key from min, so negative keys index the counts as well
+template <class in_t, class out_t>
+void count_sort(in_t src, out_t dst, size_t size, long long exp, int base, long long min, Stats* stats)
+{
+	std::vector<int> count(base);
+
+	for (auto it = count.begin(); it != count.end(); it++)
+	{
+		*it = 0;
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		count[((src[i] - min) / exp) % base]++;
+	}
+
+	for (auto it = count.begin() + 1; it != count.end(); it++)
+	{
+		*it += *(it - 1);
+	}
+
+	for (size_t i = size; i-- > 0;)
+	{
+		stats->swaps++;
+
+		dst[count[((src[i] - min) / exp) % base] - 1] = src[i];
+		count[((src[i] - min) / exp) % base]--;
+	}
+}
+
+// Whether the keys are narrow enough to count directly. With 32-bit counts and the default ratio the
+// histogram is never larger than the buffer the digit passes would allocate.
+inline bool counting_fits(size_t range, size_t size)
+{
+	return size <= UINT32_MAX && range / COUNTING_RANGE_RATIO < size;
+}
+
+// Sorts values from [min, min + range] with one histogram pass and one write pass, no buffer needed
+template <class it_t>
+void counting_sort(it_t first, size_t size, int min, size_t range, Comparator::Comparator comp, Stats* stats)
+{
+	std::vector<uint32_t> count(range + 1, 0);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		count[(size_t)((long long)first[i] - min)]++;
+	}
+
+	bool desc = comp == Comparator::DECREASING;
+	it_t out = first;
+
+	for (size_t v = 0; v <= range; v++)
+	{
+		size_t bucket = desc ? range - v : v;
+		int value = (int)(min + (long long)bucket);
+
+		stats->swaps += count[bucket];
+		out = std::fill_n(out, count[bucket], value);
+	}
+}
+
+template <class it_t>
+Stats* radix_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	if (size < 2) return stats;
+
+	int min = *first, max = *first;
+	for (auto it = first + 1; it != last; it++)
+	{
+		stats->compares++;
+
+		if (*it < min)
+		{
+			min = *it;
+		}
+		else
+		{
+			stats->compares++;
+
+			if (*it > max) max = *it;
+		}
+	}
+
+	// A narrow key range is cheaper to count directly than to run the digit passes over
+	size_t range = (size_t)((long long)max - min);
+	if (counting_fits(range, size))
+	{
+		counting_sort(first, size, min, range, comp, stats);
+		return stats;
+	}
+
+	std::vector<int> secondary(size);
+	bool in_secondary = false;
+
+	for (long long exp = 1; (long long)range / exp > 0; exp = exp << 4)
+	{
+		if (in_secondary)
+		{
+			count_sort(secondary.begin(), first, size, exp, 16, min, stats);
+		}
+		else
+		{
+			count_sort(first, secondary.begin(), size, exp, 16, min, stats);
+		}
+
+		in_secondary = !in_secondary;
+	}
+
+	if (in_secondary)
+	{
+		std::copy(secondary.begin(), secondary.end(), first);
+	}
+
+	// The digit passes always produce increasing order
+	if (comp == Comparator::DECREASING)
+	{
+		std::reverse(first, last);
+	}
+
+	return stats;
+}
+
+Stats* radix_sort(std::vector<int> &data, Comparator::Comparator comp)
+{
+	return radix_sort(data.begin(), data.end(), comp);
+}
+
+// Key whose unsigned order matches the order comp asks for, negative numbers included
+inline unsigned int flag_key(int value, Comparator::Comparator comp)
+{
+	unsigned int key = (unsigned int)value ^ 0x80000000u;
+
+	return (comp == Comparator::DECREASING) ? ~key : key;
+}
+
+// Sorts [lo, hi) on the byte of the key at shift, moving every element straight into its bucket
+// by following the displacement cycles, then sorts each bucket on the next byte.
+template <class it_t>
+void american_flag_sort_inner(it_t data, size_t lo, size_t hi, int shift, Comparator::Comparator comp, Stats* stats)
+{
+	if (hi - lo <= FLAG_CUT_OFF)
+	{
+		insertion_blocks(data + lo, hi - lo, hi - lo, comp, stats);
+		return;
+	}
+
+	size_t count[256] = { 0 };
+	size_t next[256], end[256];
+
+	for (size_t i = lo; i < hi; i++)
+	{
+		count[(flag_key(data[i], comp) >> shift) & 0xFF]++;
+	}
+
+	size_t sum = lo;
+	for (int b = 0; b < 256; b++)
+	{
+		next[b] = sum;
+		sum += count[b];
+		end[b] = sum;
+	}
+
+	for (int b = 0; b < 256; b++)
+	{
+		while (next[b] < end[b])
+		{
+			int value = data[next[b]];
+			unsigned int digit = (flag_key(value, comp) >> shift) & 0xFF;
+
+			while (digit != (unsigned int)b)
+			{
+				stats->swaps++;
+
+				std::swap(value, data[next[digit]++]);
+				digit = (flag_key(value, comp) >> shift) & 0xFF;
+			}
+
+			data[next[b]++] = value;
+		}
+	}
+
+	if (shift == 0)
+	{
+		return;
+	}
+
+	size_t start = lo;
+	for (int b = 0; b < 256; b++)
+	{
+		if (end[b] - start > 1)
+		{
+			american_flag_sort_inner(data, start, end[b], shift - 8, comp, stats);
+		}
+
+		start = end[b];
+	}
+}
+
+// In-place MSD radix sort, needs no buffer next to the data
+template <class it_t>
+Stats* american_flag_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	if (size > 1)
+	{
+		american_flag_sort_inner(first, 0, size, 24, comp, stats);
+	}
+
+	return stats;
+}
+
+Stats* american_flag_sort(std::vector<int> &data, Comparator::Comparator comp)
+{
+	return american_flag_sort(data.begin(), data.end(), comp);
+}
+
+template <class it_t>
+Stats* integer_sort_or_hybrid(it_t first, it_t last, Comparator::Comparator comp, SortType::SortType type, std::true_type)
+{
+	if (type == SortType::FLAG)
+	{
+		return american_flag_sort(first, last, comp);
+	}
+
+	return radix_sort(first, last, comp);
+}
+
+template <class it_t>
+Stats* integer_sort_or_hybrid(it_t first, it_t last, Comparator::Comparator comp, SortType::SortType, std::false_type)
+{
+	return hybrid_sort(first, last, comp);
+}
+
+// Average time of one compare in nanoseconds, measured on neighbouring elements of the range
+template <class it_t>
+double compare_cost(it_t first, size_t size, Comparator::Comparator comp)
+{
+	size_t samples = std::min(size - 1, (size_t)64);
+	size_t before = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < samples; i++)
+	{
+		before += compare(comp, first[i], first[i + 1], true);
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	// Keeps the loop from being optimized away
+	volatile size_t sink = before;
+	(void)sink;
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / samples;
+}
+
+// Picks the sort by the measured compare cost: when compares are expensive the ones that use the
+// fewest of them, merge insertion for small ranges, binary insertion up to BINARY_INSERT_MAX and merge
+// sort above that. Cheap compares go to hybrid_sort.
+// AUTO is not stable: the choice rests on a timing, so the same input can go to hybrid_sort or merge
+// insertion from one run to the next, and neither of them keeps equal elements in order. Pick MERGE or
+// BINARY directly when the order of equal elements matters.
+template <class it_t>
+Stats* auto_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	size_t size = last - first;
+
+	if (size < 2 || compare_cost(first, size, comp) < EXPENSIVE_COMPARE_NS)
+	{
+		return hybrid_sort(first, last, comp);
+	}
+
+	if (size <= MERGE_INSERT_MAX)
+	{
+		return merge_insertion_sort(first, last, comp);
+	}
+
+	if (size <= BINARY_INSERT_MAX)
+	{
+		return binary_insertion_sort(first, last, comp);
+	}
+
+	return merge_sort(first, last, comp);
+}
+
+template <class t>
+Stats* auto_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return auto_sort(data.begin(), data.end(), comp);
+}
+
+template <class it_t>
+Stats* sort_direct(it_t first, it_t last, Comparator::Comparator comp, SortType::SortType type)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	switch (type)
+	{
+	case SortType::INSERT:
+		return insertion_sort(first, last, comp);
+	case SortType::MERGE:
+		return merge_sort(first, last, comp);
+	case SortType::QUICK:
+		return quick_sort(first, last, comp);
+	case SortType::HYBRID:
+		return hybrid_sort(first, last, comp);
+	case SortType::DUAL:
+		return dual_pivot_quick_sort(first, last, comp);
+	case SortType::RADIX:
+	case SortType::FLAG:
+		return integer_sort_or_hybrid(first, last, comp, type, std::is_same<t, int>());
+	case SortType::MULTIWAY:
+		return multiway_merge_sort(first, last, comp);
+	case SortType::SAMPLE:
+		return sample_sort(first, last, comp);
+	case SortType::BINARY:
+		return binary_insertion_sort(first, last, comp);
+	case SortType::MERGE_INSERT:
+		return merge_insertion_sort(first, last, comp);
+	case SortType::AUTO:
+		return auto_sort(first, last, comp);
+	case SortType::HEAP:
+		return heap_sort(first, last, comp);
+	case SortType::INTRO:
+		return intro_sort(first, last, comp);
+	case SortType::BLOCK:
+		return block_merge_sort(first, last, comp);
+	default:
+		return nullptr;
+	}
+}
+
+template <class key_t>
+struct IndexedKey
+{
+	key_t key;
+	size_t index;
+};
+
+template <class key_t>
+bool operator==(const IndexedKey<key_t> &a, const IndexedKey<key_t> &b) { return a.key == b.key; }
+template <class key_t>
+bool operator<(const IndexedKey<key_t> &a, const IndexedKey<key_t> &b) { return a.key < b.key; }
+template <class key_t>
+bool operator<=(const IndexedKey<key_t> &a, const IndexedKey<key_t> &b) { return a.key <= b.key; }
+template <class key_t>
+bool operator>(const IndexedKey<key_t> &a, const IndexedKey<key_t> &b) { return a.key > b.key; }
+template <class key_t>
+bool operator>=(const IndexedKey<key_t> &a, const IndexedKey<key_t> &b) { return a.key >= b.key; }
+
+template <class key_t>
+std::ostream& operator<<(std::ostream &os, const IndexedKey<key_t> &e)
+{
+	return os << e.key << " @" << e.index;
+}
+
+// Key used when the records are compared as a whole
+template <class t>
+struct RecordRef
+{
+	const t* record;
+};
+
+template <class t>
+bool operator==(const RecordRef<t> &a, const RecordRef<t> &b) { return *a.record == *b.record; }
+template <class t>
+bool operator<(const RecordRef<t> &a, const RecordRef<t> &b) { return *a.record < *b.record; }
+template <class t>
+bool operator<=(const RecordRef<t> &a, const RecordRef<t> &b) { return *a.record <= *b.record; }
+template <class t>
+bool operator>(const RecordRef<t> &a, const RecordRef<t> &b) { return *a.record > *b.record; }
+template <class t>
+bool operator>=(const RecordRef<t> &a, const RecordRef<t> &b) { return *a.record >= *b.record; }
+
+template <class t>
+std::ostream& operator<<(std::ostream &os, const RecordRef<t> &r)
+{
+	return os << *r.record;
+}
+
+// Moves every record straight to its final slot by following the permutation cycles.
+// entries[k].index is the current position of the record that belongs at k; the entries are consumed.
+template <class it_t, class entry_t>
+void apply_permutation(it_t first, std::vector<entry_t> &entries, Stats* stats)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	for (size_t leader = 0; leader < entries.size(); leader++)
+	{
+		if (entries[leader].index == leader)
+		{
+			continue;
+		}
+
+		t temp = std::move(first[leader]);
+		size_t j = leader;
+
+		while (entries[j].index != leader)
+		{
+			size_t next = entries[j].index;
+
+			stats->swaps++;
+
+			first[j] = std::move(first[next]);
+			entries[j].index = j;
+			j = next;
+		}
+
+		stats->swaps++;
+
+		first[j] = std::move(temp);
+		entries[j].index = j;
+	}
+}
+
+template <class it_t, class key_fn>
+Stats* indirect_sort(it_t first, it_t last, Comparator::Comparator comp, key_fn key, SortType::SortType type = SortType::HYBRID)
+{
+	typedef typename std::decay<decltype(key(*first))>::type key_t;
+
+	size_t size = last - first;
+	std::vector<IndexedKey<key_t>> entries;
+	entries.reserve(size);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		entries.push_back({ key(first[i]), i });
+	}
+
+	Stats* stats = sort_direct(entries.begin(), entries.end(), comp, type);
+
+	if (stats)
+	{
+		apply_permutation(first, entries, stats);
+	}
+
+	return stats;
+}
+
+template <class it_t>
+Stats* indirect_sort(it_t first, it_t last, Comparator::Comparator comp, SortType::SortType type = SortType::HYBRID)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	return indirect_sort(first, last, comp, [](const t &record) { return RecordRef<t>{ &record }; }, type);
+}
+
+template <class t>
+Stats* indirect_sort(std::vector<t> &data, Comparator::Comparator comp, SortType::SortType type = SortType::HYBRID)
+{
+	return indirect_sort(data.begin(), data.end(), comp, type);
+}
+
+// Sorts records of at least min_size bytes indirectly, everything else in place
+template <class it_t>
+Stats* sort_by_type(it_t first, it_t last, Comparator::Comparator comp, SortType::SortType type, size_t min_size = INDIRECT_MIN_SIZE)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	if (sizeof(t) >= min_size)
+	{
+		return indirect_sort(first, last, comp, type);
+	}
+
+	return sort_direct(first, last, comp, type);
+}
+
+template <class t>
+Stats* sort_by_type(std::vector<t> &data, Comparator::Comparator comp, SortType::SortType type, size_t min_size = INDIRECT_MIN_SIZE)
+{
+	return sort_by_type(data.begin(), data.end(), comp, type, min_size);
+}
\ No newline at end of file
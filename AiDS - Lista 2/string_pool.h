@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <string_view>
+
+// Keeps the characters of many small strings in large contiguous blocks.
+// Views stay valid until clear(), sorting them never touches the characters.
+class StringPool
+{
+public:
+	typedef std::vector<std::string_view>::iterator iterator;
+
+	explicit StringPool(size_t block_size = 1 << 16) : block_size(block_size), used(block_size) {}
+
+	void reserve(size_t count)
+	{
+		views.reserve(count);
+	}
+
+	// Reserves length characters for a new string and returns them for filling
+	char* allocate(size_t length)
+	{
+		if (length > block_size)
+		{
+			blocks.emplace_back(new char[length]);
+			char* str = blocks.back().get();
+
+			// Keep filling the current block afterwards
+			if (blocks.size() > 1) std::swap(blocks[blocks.size() - 1], blocks[blocks.size() - 2]);
+
+			views.emplace_back(str, length);
+			return str;
+		}
+
+		if (blocks.empty() || used + length > block_size)
+		{
+			blocks.emplace_back(new char[block_size]);
+			used = 0;
+		}
+
+		char* str = blocks.back().get() + used;
+		used += length;
+
+		views.emplace_back(str, length);
+		return str;
+	}
+
+	std::string_view add(std::string_view str)
+	{
+		char* dst = allocate(str.size());
+		std::copy(str.begin(), str.end(), dst);
+
+		return views.back();
+	}
+
+	void clear()
+	{
+		blocks.clear();
+		views.clear();
+		used = block_size;
+	}
+
+	size_t size() const { return views.size(); }
+	std::string_view& operator[](size_t i) { return views[i]; }
+
+	iterator begin() { return views.begin(); }
+	iterator end() { return views.end(); }
+
+	std::vector<std::string_view>& strings() { return views; }
+
+private:
+	size_t block_size, used;
+	std::vector<std::unique_ptr<char[]>> blocks;
+	std::vector<std::string_view> views;
+};
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "sorting.h"
+
+// First 8 characters packed big-endian, so integer order matches string order
+template <class t>
+unsigned long long string_prefix(const t &str)
+{
+	unsigned long long prefix = 0;
+
+	for (size_t i = 0; i < 8; i++)
+	{
+		prefix <<= 8;
+
+		if (i < str.size())
+		{
+			prefix |= (unsigned char)str[i];
+		}
+	}
+
+	return prefix;
+}
+
+template <class t>
+struct PrefixKey
+{
+	unsigned long long prefix;
+	const t* str;
+};
+
+// Only strings with the same prefix are compared in full
+template <class t>
+int prefix_compare(const PrefixKey<t> &a, const PrefixKey<t> &b)
+{
+	if (a.prefix != b.prefix)
+	{
+		return (a.prefix < b.prefix) ? -1 : 1;
+	}
+
+	return a.str->compare(*b.str);
+}
+
+template <class t>
+bool operator==(const PrefixKey<t> &a, const PrefixKey<t> &b) { return prefix_compare(a, b) == 0; }
+template <class t>
+bool operator<(const PrefixKey<t> &a, const PrefixKey<t> &b) { return prefix_compare(a, b) < 0; }
+template <class t>
+bool operator<=(const PrefixKey<t> &a, const PrefixKey<t> &b) { return prefix_compare(a, b) <= 0; }
+template <class t>
+bool operator>(const PrefixKey<t> &a, const PrefixKey<t> &b) { return prefix_compare(a, b) > 0; }
+template <class t>
+bool operator>=(const PrefixKey<t> &a, const PrefixKey<t> &b) { return prefix_compare(a, b) >= 0; }
+
+template <class t>
+std::ostream& operator<<(std::ostream &os, const PrefixKey<t> &key)
+{
+	return os << *key.str;
+}
+
+template <class it_t>
+Stats* prefix_sort(it_t first, it_t last, Comparator::Comparator comp, SortType::SortType type = SortType::HYBRID)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	return indirect_sort(first, last, comp, [](const t &str) { return PrefixKey<t>{ string_prefix(str), &str }; }, type);
+}
+
+template <class t>
+Stats* prefix_sort(std::vector<t> &data, Comparator::Comparator comp, SortType::SortType type = SortType::HYBRID)
+{
+	return prefix_sort(data.begin(), data.end(), comp, type);
+}
+
+// Merges [x, mid) and [mid, end) of src into dst. lcp[k] holds the longest common prefix
+// of element k and the one before it in its run, so only characters past it are compared.
+template <class t>
+void lcp_merge(std::vector<t> &src, std::vector<size_t> &src_lcp, std::vector<t> &dst, std::vector<size_t> &dst_lcp,
+	size_t x, size_t mid, size_t end, Comparator::Comparator comp, Stats* stats)
+{
+	size_t i = x, j = mid, it = x;
+	size_t ha = 0, hb = 0;
+
+	while (i < mid && j < end)
+	{
+		stats->compares++;
+		stats->swaps++;
+
+		if (ha > hb)
+		{
+			dst_lcp[it] = ha;
+			dst[it++] = std::move(src[i++]);
+			ha = (i < mid) ? src_lcp[i] : 0;
+		}
+		else if (hb > ha)
+		{
+			dst_lcp[it] = hb;
+			dst[it++] = std::move(src[j++]);
+			hb = (j < end) ? src_lcp[j] : 0;
+		}
+		else
+		{
+			const t &a = src[i];
+			const t &b = src[j];
+			size_t l = ha;
+
+			while (l < a.size() && l < b.size() && a[l] == b[l])
+			{
+				stats->characters++;
+				l++;
+			}
+
+			stats->characters++;
+
+			bool a_first;
+			if (comp == Comparator::INCREASING)
+			{
+				a_first = l == a.size() || (l < b.size() && (unsigned char)a[l] < (unsigned char)b[l]);
+			}
+			else
+			{
+				a_first = l == b.size() || (l < a.size() && (unsigned char)a[l] > (unsigned char)b[l]);
+			}
+
+			if (a_first)
+			{
+				dst_lcp[it] = ha;
+				dst[it++] = std::move(src[i++]);
+				ha = (i < mid) ? src_lcp[i] : 0;
+				hb = l;
+			}
+			else
+			{
+				dst_lcp[it] = hb;
+				dst[it++] = std::move(src[j++]);
+				hb = (j < end) ? src_lcp[j] : 0;
+				ha = l;
+			}
+		}
+	}
+
+	// The first leftover element is now measured against the last one written
+	if (i < mid) src_lcp[i] = ha;
+	if (j < end) src_lcp[j] = hb;
+
+	for (; i < mid; i++, it++)
+	{
+		stats->swaps++;
+
+		dst_lcp[it] = src_lcp[i];
+		dst[it] = std::move(src[i]);
+	}
+
+	for (; j < end; j++, it++)
+	{
+		stats->swaps++;
+
+		dst_lcp[it] = src_lcp[j];
+		dst[it] = std::move(src[j]);
+	}
+}
+
+template <class it_t>
+Stats* lcp_merge_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+
+	std::vector<t> primary(std::make_move_iterator(first), std::make_move_iterator(last));
+	std::vector<t> secondary(size);
+	std::vector<size_t> primary_lcp(size, 0);
+	std::vector<size_t> secondary_lcp(size, 0);
+
+	for (size_t jump = 1; jump < size; jump *= 2)
+	{
+		for (size_t x = 0; x < size; x += jump * 2)
+		{
+			lcp_merge(primary, primary_lcp, secondary, secondary_lcp, x, std::min(size, x + jump), std::min(size, x + jump * 2), comp, stats);
+		}
+
+		primary.swap(secondary);
+		primary_lcp.swap(secondary_lcp);
+	}
+
+	std::move(primary.begin(), primary.end(), first);
+
+	return stats;
+}
+
+template <class t>
+Stats* lcp_merge_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return lcp_merge_sort(data.begin(), data.end(), comp);
+}
+
+// Replaces every value with its rank among the distinct values, ordered by comp.
+// Only the distinct values are sorted, which is counted in encode_compares.
+template <class it_t, class t>
+Stats* dictionary_encode(it_t first, it_t last, Comparator::Comparator comp, std::vector<t> &dictionary, std::vector<int> &codes)
+{
+	size_t size = last - first;
+	Stats* stats = new Stats{ size, 0, 0, 0.0 };
+	std::unordered_map<t, int> code_of;
+
+	dictionary.clear();
+	codes.resize(size);
+
+	for (auto it = first; it != last; it++)
+	{
+		if (code_of.emplace(*it, 0).second)
+		{
+			dictionary.push_back(*it);
+		}
+	}
+
+	Stats* dictionary_stats = hybrid_sort(dictionary, comp);
+	stats->encode_compares = dictionary_stats->compares;
+	delete dictionary_stats;
+
+	for (size_t i = 0; i < dictionary.size(); i++)
+	{
+		code_of[dictionary[i]] = (int)i;
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		codes[i] = code_of.find(first[i])->second;
+	}
+
+	return stats;
+}
+
+template <class it_t>
+Stats* dictionary_sort(it_t first, it_t last, Comparator::Comparator comp)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	std::vector<t> dictionary;
+	std::vector<int> codes;
+
+	Stats* stats = dictionary_encode(first, last, comp, dictionary, codes);
+	Stats* code_stats = radix_sort(codes.begin(), codes.end(), Comparator::INCREASING);
+
+	stats->compares += code_stats->compares;
+	stats->swaps += code_stats->swaps;
+	delete code_stats;
+
+	for (size_t i = 0; i < codes.size(); i++)
+	{
+		first[i] = dictionary[codes[i]];
+	}
+
+	return stats;
+}
+
+template <class t>
+Stats* dictionary_sort(std::vector<t> &data, Comparator::Comparator comp)
+{
+	return dictionary_sort(data.begin(), data.end(), comp);
+}
+
+// Leaves the data untouched, permutation[k] is the index of the element that belongs at k.
+// Equal values keep their original order.
+template <class it_t>
+Stats* dictionary_permutation(it_t first, it_t last, Comparator::Comparator comp, std::vector<size_t> &permutation)
+{
+	typedef typename std::iterator_traits<it_t>::value_type t;
+
+	std::vector<t> dictionary;
+	std::vector<int> codes;
+
+	Stats* stats = dictionary_encode(first, last, comp, dictionary, codes);
+	std::vector<size_t> count(dictionary.size() + 1, 0);
+
+	for (size_t i = 0; i < codes.size(); i++)
+	{
+		count[codes[i] + 1]++;
+	}
+
+	for (size_t i = 1; i < count.size(); i++)
+	{
+		count[i] += count[i - 1];
+	}
+
+	permutation.resize(codes.size());
+
+	for (size_t i = 0; i < codes.size(); i++)
+	{
+		stats->swaps++;
+
+		permutation[count[codes[i]]++] = i;
+	}
+
+	return stats;
+}
+
+template <class it_t>
+Stats* sort_strings(it_t first, it_t last, Comparator::Comparator comp, SortType::SortType type)
+{
+	switch (type)
+	{
+	case SortType::PREFIX:
+		return prefix_sort(first, last, comp);
+	case SortType::LCP:
+		return lcp_merge_sort(first, last, comp);
+	case SortType::DICT:
+		return dictionary_sort(first, last, comp);
+	default:
+		return sort_by_type(first, last, comp, type);
+	}
+}
+
+template <class t>
+Stats* sort_strings(std::vector<t> &data, Comparator::Comparator comp, SortType::SortType type)
+{
+	return sort_strings(data.begin(), data.end(), comp, type);
+}